@@ -0,0 +1,61 @@
+// Replacement global allocation functions counting heap allocations for
+// --stats. Only the command line tool links this file, so programs using the
+// library keep their own operator new.
+
+#include <cstdlib>
+#include <new>
+
+#include "stats.h"
+
+void* operator new(std::size_t size) {
+    Stats::count_allocation(size);
+    while (true) {
+        if (void* p = std::malloc(size ? size : 1)) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+// The nothrow and array forms are replaced too, so every block freed by the
+// operator delete below was allocated with malloc, whichever runtime
+// (a sanitizer, for one) provides the forms not defined here
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try {
+        return ::operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return ::operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
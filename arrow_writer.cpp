@@ -0,0 +1,311 @@
+#include "arrow_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// Identifiers from Arrow's Schema.fbs and Message.fbs
+constexpr int16_t kMetadataV5 = 4;
+constexpr uint8_t kHeaderSchema = 1;
+constexpr uint8_t kHeaderRecordBatch = 3;
+constexpr uint8_t kTypeInt = 2;
+constexpr uint8_t kTypeFloatingPoint = 3;
+constexpr uint8_t kTypeUtf8 = 5;
+constexpr uint8_t kTypeLargeUtf8 = 20;
+constexpr int16_t kPrecisionDouble = 2;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+constexpr int16_t kHostEndianness = 1;
+#else
+constexpr int16_t kHostEndianness = 0;
+#endif
+
+// Minimal flatbuffer builder. Like the flatbuffers library it builds back to
+// front, so positions are distances from the end of the buffer and children
+// must be created before the tables that refer to them.
+class FlatBuilder {
+public:
+    uint32_t size() const { return static_cast<uint32_t>(m_buf.size()); }
+
+    template <typename T>
+    void prepend_scalar(T value) {
+        align(sizeof(T));
+        char bytes[sizeof(T)];
+        std::memcpy(bytes, &value, sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        std::reverse(bytes, bytes + sizeof(T));
+#endif
+        m_buf.insert(0, bytes, sizeof(T));
+    }
+
+    // Pad so that `extra` more bytes end on an `alignment` boundary
+    void align(size_t alignment, size_t extra = 0) {
+        m_min_align = std::max(m_min_align, alignment);
+        size_t pad = (alignment - (m_buf.size() + extra) % alignment) % alignment;
+        m_buf.insert(0, pad, '\0');
+    }
+
+    uint32_t create_string(const std::string& s) {
+        align(4, s.size() + 1);
+        m_buf.insert(0, 1, '\0');
+        m_buf.insert(0, s);
+        prepend_scalar(static_cast<uint32_t>(s.size()));
+        return size();
+    }
+
+    uint32_t create_offset_vector(const std::vector<uint32_t>& targets) {
+        align(4, 4 * targets.size());
+        for (auto it = targets.rbegin(); it != targets.rend(); ++it) {
+            prepend_offset(*it);
+        }
+        prepend_scalar(static_cast<uint32_t>(targets.size()));
+        return size();
+    }
+
+    // Vector of 8-byte aligned structs, already serialized little-endian
+    uint32_t create_struct_vector(const std::string& bytes, size_t count) {
+        align(4, bytes.size());
+        align(8, bytes.size());
+        m_buf.insert(0, bytes);
+        prepend_scalar(static_cast<uint32_t>(count));
+        return size();
+    }
+
+    void start_table() {
+        m_fields.clear();
+        m_table_start = size();
+    }
+
+    template <typename T>
+    void add_scalar(uint16_t field, T value) {
+        prepend_scalar(value);
+        m_fields.push_back({field, size()});
+    }
+
+    void add_offset(uint16_t field, uint32_t target) {
+        prepend_offset(target);
+        m_fields.push_back({field, size()});
+    }
+
+    uint32_t end_table() {
+        prepend_scalar<int32_t>(0); // offset to the vtable, patched below
+        const uint32_t table = size();
+        uint16_t num_fields = 0;
+        for (const auto& field : m_fields) {
+            num_fields = std::max<uint16_t>(num_fields, field.id + 1);
+        }
+        std::vector<uint16_t> vtable(num_fields, 0);
+        for (const auto& field : m_fields) {
+            vtable[field.id] = static_cast<uint16_t>(table - field.pos);
+        }
+        for (auto it = vtable.rbegin(); it != vtable.rend(); ++it) {
+            prepend_scalar(*it);
+        }
+        prepend_scalar(static_cast<uint16_t>(table - m_table_start));
+        prepend_scalar(static_cast<uint16_t>(4 + 2 * num_fields));
+
+        // The vtable sits right before the table: table - soffset = vtable
+        int32_t soffset = static_cast<int32_t>(size() - table);
+        FlatBuilder patch;
+        patch.prepend_scalar(soffset);
+        m_buf.replace(m_buf.size() - table, 4, patch.m_buf);
+        return table;
+    }
+
+    std::string finish(uint32_t root) {
+        align(std::max<size_t>(m_min_align, 8), 4);
+        prepend_offset(root);
+        return m_buf;
+    }
+
+private:
+    struct Field {
+        uint16_t id;
+        uint32_t pos;
+    };
+
+    void prepend_offset(uint32_t target) {
+        align(4);
+        prepend_scalar(size() + 4 - target);
+    }
+
+    std::string m_buf;
+    size_t m_min_align = 1;
+    uint32_t m_table_start = 0;
+    std::vector<Field> m_fields;
+};
+
+// Little-endian struct fields for create_struct_vector()
+void put_le(std::string& out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; i++) {
+        out += static_cast<char>(value >> (8 * i));
+    }
+}
+
+size_t padded(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+struct ArrowWriter::Column {
+    std::string name;
+    uint8_t type;
+    int32_t int_bit_width = 0; // for kTypeInt
+    int64_t length;
+    std::vector<std::string_view> buffers; // validity first, always empty
+};
+
+void ArrowWriter::write_strings(const std::string& name, std::string_view data, const std::vector<int64_t>& offsets) {
+    Column column{name, kTypeUtf8, 0, static_cast<int64_t>(offsets.size()) - 1, {}};
+    std::vector<int32_t> offsets32;
+    std::string_view offset_bytes;
+    if (data.size() <= static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+        offsets32.assign(offsets.begin(), offsets.end());
+        offset_bytes = std::string_view(reinterpret_cast<const char*>(offsets32.data()), offsets32.size() * 4);
+    } else {
+        column.type = kTypeLargeUtf8;
+        offset_bytes = std::string_view(reinterpret_cast<const char*>(offsets.data()), offsets.size() * 8);
+    }
+    column.buffers = {std::string_view(), offset_bytes, data};
+    write_file(column);
+}
+
+void ArrowWriter::write_int32(const std::string& name, const int32_t* values, uint64_t count) {
+    write_file({name, kTypeInt, 32, static_cast<int64_t>(count),
+                {std::string_view(), std::string_view(reinterpret_cast<const char*>(values), count * 4)}});
+}
+
+void ArrowWriter::write_int64(const std::string& name, const int64_t* values, uint64_t count) {
+    write_file({name, kTypeInt, 64, static_cast<int64_t>(count),
+                {std::string_view(), std::string_view(reinterpret_cast<const char*>(values), count * 8)}});
+}
+
+void ArrowWriter::write_float64(const std::string& name, const double* values, uint64_t count) {
+    write_file({name, kTypeFloatingPoint, 0, static_cast<int64_t>(count),
+                {std::string_view(), std::string_view(reinterpret_cast<const char*>(values), count * 8)}});
+}
+
+namespace {
+
+uint32_t build_schema(FlatBuilder& b, const std::string& name, uint8_t type, int32_t int_bit_width) {
+    b.start_table();
+    if (type == kTypeInt) {
+        b.add_scalar<int32_t>(0, int_bit_width);
+        b.add_scalar<uint8_t>(1, 1); // is_signed
+    } else if (type == kTypeFloatingPoint) {
+        b.add_scalar<int16_t>(0, kPrecisionDouble);
+    }
+    uint32_t type_table = b.end_table();
+    uint32_t name_string = b.create_string(name);
+    uint32_t children = b.create_offset_vector({});
+
+    b.start_table();
+    b.add_offset(0, name_string);
+    b.add_offset(3, type_table);
+    b.add_offset(5, children);
+    b.add_scalar<uint8_t>(1, 0); // nullable
+    b.add_scalar<uint8_t>(2, type);
+    uint32_t field = b.end_table();
+    uint32_t fields = b.create_offset_vector({field});
+
+    b.start_table();
+    b.add_offset(1, fields);
+    b.add_scalar<int16_t>(0, kHostEndianness);
+    return b.end_table();
+}
+
+std::string build_message(FlatBuilder& b, uint8_t header_type, uint32_t header, int64_t body_length) {
+    b.start_table();
+    b.add_scalar<int64_t>(3, body_length);
+    b.add_offset(2, header);
+    b.add_scalar<int16_t>(0, kMetadataV5);
+    b.add_scalar<uint8_t>(1, header_type);
+    return b.finish(b.end_table());
+}
+
+} // namespace
+
+void ArrowWriter::write_file(const Column& column) {
+    static const char kMagic[] = "ARROW1";
+    write(std::string_view(kMagic, 6));
+    pad_to(8);
+
+    // Encapsulated messages: continuation marker, metadata length, flatbuffer
+    // padded to 8 bytes, then the body
+    auto write_message = [this](const std::string& metadata) {
+        size_t metadata_length = padded(metadata.size(), 8);
+        std::string prefix;
+        put_le(prefix, 0xFFFFFFFF, 4);
+        put_le(prefix, metadata_length, 4);
+        write(prefix);
+        write(metadata);
+        pad_to(8);
+        return 8 + metadata_length;
+    };
+
+    FlatBuilder schema;
+    write_message(build_message(schema, kHeaderSchema, build_schema(schema, column.name, column.type, column.int_bit_width), 0));
+
+    std::string nodes;
+    put_le(nodes, column.length, 8);
+    put_le(nodes, 0, 8); // null_count
+    std::string buffers;
+    uint64_t body_length = 0;
+    for (std::string_view buffer : column.buffers) {
+        put_le(buffers, body_length, 8);
+        put_le(buffers, buffer.size(), 8);
+        body_length += padded(buffer.size(), 8);
+    }
+    FlatBuilder batch;
+    uint32_t buffer_vector = batch.create_struct_vector(buffers, column.buffers.size());
+    uint32_t node_vector = batch.create_struct_vector(nodes, 1);
+    batch.start_table();
+    batch.add_scalar<int64_t>(0, column.length);
+    batch.add_offset(1, node_vector);
+    batch.add_offset(2, buffer_vector);
+    uint32_t record_batch = batch.end_table();
+
+    const uint64_t batch_offset = m_pos;
+    const size_t batch_metadata_length = write_message(build_message(batch, kHeaderRecordBatch, record_batch, body_length));
+    for (std::string_view buffer : column.buffers) {
+        write(buffer);
+        pad_to(8);
+    }
+
+    std::string end_of_stream;
+    put_le(end_of_stream, 0xFFFFFFFF, 4);
+    put_le(end_of_stream, 0, 4);
+    write(end_of_stream);
+
+    // Footer: the schema again and the Block of the record batch
+    FlatBuilder footer;
+    std::string block;
+    put_le(block, batch_offset, 8);
+    put_le(block, batch_metadata_length, 4);
+    put_le(block, 0, 4); // padding
+    put_le(block, body_length, 8);
+    uint32_t record_batches = footer.create_struct_vector(block, 1);
+    uint32_t footer_schema = build_schema(footer, column.name, column.type, column.int_bit_width);
+    footer.start_table();
+    footer.add_offset(1, footer_schema);
+    footer.add_offset(3, record_batches);
+    footer.add_scalar<int16_t>(0, kMetadataV5);
+    std::string footer_bytes = footer.finish(footer.end_table());
+    write(footer_bytes);
+    std::string footer_length;
+    put_le(footer_length, footer_bytes.size(), 4);
+    write(footer_length);
+    write(std::string_view(kMagic, 6));
+}
+
+void ArrowWriter::write(std::string_view bytes) {
+    m_out.write_bytes(bytes);
+    m_pos += bytes.size();
+}
+
+void ArrowWriter::pad_to(size_t alignment) {
+    static const char kZeros[8] = {};
+    write(std::string_view(kZeros, padded(m_pos, alignment) - m_pos));
+}
@@ -0,0 +1,43 @@
+#ifndef ARROW_WRITER_H_
+#define ARROW_WRITER_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "output_writer.h"
+
+// Writes a dictionary as an Apache Arrow IPC file (the "ARROW1" random access
+// format): one non-nullable column in a single record batch, so a consumer
+// can map the file and use the buffers in place.
+//
+// The flatbuffer metadata (Schema, RecordBatch, Footer) is built by hand, no
+// Arrow library is needed. Every write_* call produces a complete file; the
+// buffers are written in host byte order and the schema says which.
+class ArrowWriter {
+public:
+    explicit ArrowWriter(OutputWriter& out) : m_out(out) {}
+
+    // String column from `data` and `offsets`, value i spanning
+    // [offsets[i], offsets[i + 1]). Written as utf8 (32-bit offsets) when
+    // the data fits, as large_utf8 otherwise.
+    void write_strings(const std::string& name, std::string_view data, const std::vector<int64_t>& offsets);
+
+    // Numeric columns from `count` values
+    void write_int32(const std::string& name, const int32_t* values, uint64_t count);
+    void write_int64(const std::string& name, const int64_t* values, uint64_t count);
+    void write_float64(const std::string& name, const double* values, uint64_t count);
+
+private:
+    struct Column;
+
+    void write_file(const Column& column);
+    void write(std::string_view bytes);
+    void pad_to(size_t alignment);
+
+    OutputWriter& m_out;
+    uint64_t m_pos = 0;
+};
+
+#endif  // ARROW_WRITER_H_
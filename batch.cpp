@@ -0,0 +1,168 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+
+#include "thread_pool.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+// Shell-style match of * and ? against a whole file name
+bool wildcard_match(const char* pattern, const char* name) {
+    if (*pattern == '\0') return *name == '\0';
+    if (*pattern == '*') {
+        for (const char* rest = name;; rest++) {
+            if (wildcard_match(pattern + 1, rest)) return true;
+            if (*rest == '\0') return false;
+        }
+    }
+    return *name != '\0' && (*pattern == '?' || *pattern == *name) && wildcard_match(pattern + 1, name + 1);
+}
+
+std::vector<std::string> sorted_matches(const fs::path& dir, const std::string& pattern) {
+    std::vector<std::string> matches;
+    for (const auto& entry : fs::directory_iterator(dir.empty() ? fs::path(".") : dir)) {
+        if (entry.is_regular_file() && wildcard_match(pattern.c_str(), entry.path().filename().string().c_str())) {
+            matches.push_back(entry.path().string());
+        }
+    }
+    std::sort(matches.begin(), matches.end());
+    return matches;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+std::vector<std::string> expand_inputs(const std::vector<std::string>& inputs) {
+    std::vector<std::string> files;
+    for (const std::string& input : inputs) {
+        if (input.size() > 1 && input[0] == '@') {
+            std::ifstream list(input.substr(1));
+            if (!list) {
+                throw std::runtime_error("Error opening file list: " + input.substr(1));
+            }
+            std::string line;
+            while (std::getline(list, line)) {
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                if (!line.empty()) files.push_back(line);
+            }
+            continue;
+        }
+        fs::path path(input);
+        std::string name = path.filename().string();
+        if (name.find_first_of("*?") != std::string::npos) {
+            std::vector<std::string> matches = sorted_matches(path.parent_path(), name);
+            files.insert(files.end(), matches.begin(), matches.end());
+        } else if (fs::is_directory(path)) {
+            std::vector<std::string> matches = sorted_matches(path, "*.dictionary");
+            files.insert(files.end(), matches.begin(), matches.end());
+        } else {
+            files.push_back(input);
+        }
+    }
+    return files;
+}
+
+bool BatchReport::failed() const {
+    return std::any_of(results.begin(), results.end(), [](const BatchResult& result) { return !result.error.empty(); });
+}
+
+BatchReport run_batch(const std::vector<std::string>& inputs, const std::string& out_dir, const std::string& extension,
+                      size_t threads, const BatchDecodeFn& decode_file) {
+    const auto start = std::chrono::steady_clock::now();
+    fs::create_directories(out_dir);
+
+    BatchReport report;
+    report.results.resize(inputs.size());
+    std::map<std::string, int> stems;
+    for (size_t i = 0; i < inputs.size(); i++) {
+        BatchResult& result = report.results[i];
+        result.input = inputs[i];
+        std::string stem = fs::path(inputs[i]).stem().string();
+        int seen = ++stems[stem];
+        if (seen > 1) stem += "-" + std::to_string(seen);
+        result.output = (fs::path(out_dir) / (stem + extension)).string();
+        std::error_code ec;
+        result.input_bytes = fs::file_size(inputs[i], ec);
+        if (ec) result.input_bytes = 0;
+    }
+
+    std::vector<size_t> order(inputs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return report.results[a].input_bytes > report.results[b].input_bytes;
+    });
+
+    // Every worker takes the next largest file until none is left
+    std::atomic<size_t> next{0};
+    auto worker = [&]() {
+        for (size_t i; (i = next++) < order.size();) {
+            BatchResult& result = report.results[order[i]];
+            const auto file_start = std::chrono::steady_clock::now();
+            try {
+                result.values = decode_file(result.input, result.output);
+            } catch (const std::exception& e) {
+                result.error = e.what();
+                std::error_code ec;
+                fs::remove(result.output, ec); // no partial output for a failed file
+            }
+            result.seconds = seconds_since(file_start);
+        }
+    };
+    ThreadPool pool(threads);
+    std::vector<std::future<void>> workers;
+    for (size_t i = 0; i < pool.size(); i++) {
+        workers.push_back(pool.submit(worker));
+    }
+    for (auto& done : workers) {
+        done.get();
+    }
+
+    report.seconds = seconds_since(start);
+    return report;
+}
+
+void print_batch_report(const BatchReport& report, std::ostream& out) {
+    auto mb = [](uint64_t bytes) { return bytes / (1024.0 * 1024.0); };
+    auto rate = [](double amount, double seconds) { return seconds > 0 ? amount / seconds : 0.0; };
+
+    uint64_t total_bytes = 0;
+    uint64_t total_values = 0;
+    double busy_seconds = 0;
+    size_t failures = 0;
+    out << std::fixed;
+    for (const BatchResult& result : report.results) {
+        out << result.input << ": ";
+        if (!result.error.empty()) {
+            out << "FAILED: " << result.error << "\n";
+            failures++;
+            continue;
+        }
+        out << std::setprecision(2) << mb(result.input_bytes) << " MB, " << result.values << " values, "
+            << std::setprecision(3) << result.seconds * 1000 << " ms, "
+            << std::setprecision(1) << rate(mb(result.input_bytes), result.seconds) << " MB/s, "
+            << std::setprecision(0) << rate(result.values, result.seconds) << " values/s\n";
+        total_bytes += result.input_bytes;
+        total_values += result.values;
+        busy_seconds += result.seconds;
+    }
+    out << "total: " << report.results.size() - failures << " files";
+    if (failures) out << " (" << failures << " failed)";
+    out << ", " << std::setprecision(2) << mb(total_bytes) << " MB, " << total_values << " values in "
+        << std::setprecision(3) << report.seconds * 1000 << " ms wall (" << busy_seconds * 1000 << " ms busy), "
+        << std::setprecision(1) << rate(mb(total_bytes), report.seconds) << " MB/s, "
+        << std::setprecision(0) << rate(total_values, report.seconds) << " values/s\n";
+    out << std::defaultfloat;
+}
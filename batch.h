@@ -0,0 +1,47 @@
+#ifndef BATCH_H_
+#define BATCH_H_
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Expand the batch inputs into dictionary file paths: a directory stands for
+// its *.dictionary files, a path whose file name contains * or ? is matched
+// against its directory, "@list" reads one path per line from the file list,
+// anything else is taken as a file. Throws std::runtime_error for missing
+// directories and lists.
+std::vector<std::string> expand_inputs(const std::vector<std::string>& inputs);
+
+struct BatchResult {
+    std::string input;
+    std::string output;
+    uint64_t input_bytes = 0;
+    uint64_t values = 0;
+    double seconds = 0;
+    std::string error; // empty on success
+};
+
+struct BatchReport {
+    std::vector<BatchResult> results; // in input order
+    double seconds = 0;               // wall time of the whole batch
+
+    bool failed() const;
+};
+
+// Writes one input to one output path and returns the number of values
+// written, throwing on errors
+using BatchDecodeFn = std::function<uint64_t(const std::string& input, const std::string& output)>;
+
+// Decode every input into out_dir/<file stem><extension> on `threads` workers
+// (0 = all cores). Files are handed out largest first so a big file never
+// starts last. A failing file is recorded in its result and the others go on.
+// Stems that repeat across directories get a -2, -3, ... suffix.
+BatchReport run_batch(const std::vector<std::string>& inputs, const std::string& out_dir, const std::string& extension,
+                      size_t threads, const BatchDecodeFn& decode_file);
+
+// Per-file and aggregate throughput table
+void print_batch_report(const BatchReport& report, std::ostream& out);
+
+#endif  // BATCH_H_
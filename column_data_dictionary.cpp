@@ -1,12 +1,34 @@
-// This is a generated file! Please edit source .ksy file and use kaitai-struct-compiler to rebuild
+// Generated from dictionary.ksy by kaitai-struct-compiler, then extended by hand (see column_data_dictionary.h)
 
 #include "column_data_dictionary.h"
 #include "kaitai/exceptions.h"
 
-column_data_dictionary_t::column_data_dictionary_t(kaitai::kstream* p__io, kaitai::kstruct* p__parent, column_data_dictionary_t* p__root) : kaitai::kstruct(p__io) {
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Copy `count` little-endian elements of type T from src into out
+template <typename T>
+void copy_le(const char* src, uint64_t count, T* out) {
+    std::memcpy(out, src, count * sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    char* bytes = reinterpret_cast<char*>(out);
+    for (uint64_t i = 0; i < count; i++, bytes += sizeof(T)) {
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+#endif
+}
+
+} // namespace
+
+column_data_dictionary_t::column_data_dictionary_t(kaitai::kstream* p__io, kaitai::kstruct* p__parent, column_data_dictionary_t* /* p__root */, read_mode_t p_read_mode) : kaitai::kstruct(p__io) {
     m__parent = p__parent;
     m__root = this;
+    m_read_mode = p_read_mode;
     m_hash_information = 0;
+    m_data = 0;
+    n_data = true;
 
     try {
         _read();
@@ -18,24 +40,26 @@ column_data_dictionary_t::column_data_dictionary_t(kaitai::kstream* p__io, kaita
 
 void column_data_dictionary_t::_read() {
     m_dictionary_type = static_cast<column_data_dictionary_t::dictionary_types_t>(m__io->read_s4le());
-    m_hash_information = new hash_info_t(m__io, this, m__root);
+    m_hash_information = m__root->_arena_new<hash_info_t>(m__io, this, m__root);
     n_data = true;
     switch (dictionary_type()) {
     case column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_STRING: {
         n_data = false;
-        m_data = new string_data_t(m__io, this, m__root);
+        m_data = m__root->_arena_new<string_data_t>(m__io, this, m__root);
         break;
     }
     case column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_LONG: {
         n_data = false;
-        m_data = new number_data_t(m__io, this, m__root);
+        m_data = m__root->_arena_new<number_data_t>(m__io, this, m__root);
         break;
     }
     case column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_REAL: {
         n_data = false;
-        m_data = new number_data_t(m__io, this, m__root);
+        m_data = m__root->_arena_new<number_data_t>(m__io, this, m__root);
         break;
     }
+    default:
+        break;
     }
 }
 
@@ -44,38 +68,7 @@ column_data_dictionary_t::~column_data_dictionary_t() {
 }
 
 void column_data_dictionary_t::_clean_up() {
-    if (m_hash_information) {
-        delete m_hash_information; m_hash_information = 0;
-    }
-    if (!n_data) {
-        if (m_data) {
-            delete m_data; m_data = 0;
-        }
-    }
-}
-
-column_data_dictionary_t::string_record_handle_t::string_record_handle_t(kaitai::kstream* p__io, column_data_dictionary_t::dictionary_record_handles_vector_t* p__parent, column_data_dictionary_t* p__root) : kaitai::kstruct(p__io) {
-    m__parent = p__parent;
-    m__root = p__root;
-
-    try {
-        _read();
-    } catch(...) {
-        _clean_up();
-        throw;
-    }
-}
-
-void column_data_dictionary_t::string_record_handle_t::_read() {
-    m_bit_or_byte_offset = m__io->read_u4le();
-    m_page_id = m__io->read_u4le();
-}
-
-column_data_dictionary_t::string_record_handle_t::~string_record_handle_t() {
-    _clean_up();
-}
-
-void column_data_dictionary_t::string_record_handle_t::_clean_up() {
+    // Nothing to free: the whole tree lives in m_arena, see _arena_new()
 }
 
 column_data_dictionary_t::string_data_t::string_data_t(kaitai::kstream* p__io, column_data_dictionary_t* p__parent, column_data_dictionary_t* p__root) : kaitai::kstruct(p__io) {
@@ -83,6 +76,7 @@ column_data_dictionary_t::string_data_t::string_data_t(kaitai::kstream* p__io, c
     m__root = p__root;
     m_page_layout_information = 0;
     m_dictionary_pages = 0;
+    f_dictionary_record_handles_vector_info = false;
     m_dictionary_record_handles_vector_info = 0;
 
     try {
@@ -94,13 +88,28 @@ column_data_dictionary_t::string_data_t::string_data_t(kaitai::kstream* p__io, c
 }
 
 void column_data_dictionary_t::string_data_t::_read() {
-    m_page_layout_information = new page_layout_t(m__io, this, m__root);
-    m_dictionary_pages = new std::vector<dictionary_page_t*>();
+    m_page_layout_information = m__root->_arena_new<page_layout_t>(m__io, this, m__root);
+    m_dictionary_pages = m__root->_arena_vector<dictionary_page_t*>();
     const int l_dictionary_pages = page_layout_information()->store_page_count();
     for (int i = 0; i < l_dictionary_pages; i++) {
-        m_dictionary_pages->push_back(new dictionary_page_t(m__io, this, m__root));
+        m_dictionary_pages->push_back(m__root->_arena_new<dictionary_page_t>(m__io, this, m__root));
+    }
+    m_dictionary_record_handles_vector_info_ofs = m__io->pos();
+    if (_root()->read_mode() == column_data_dictionary_t::READ_MODE_EAGER) {
+        m_dictionary_record_handles_vector_info = m__root->_arena_new<dictionary_record_handles_vector_t>(m__io, this, m__root);
+        f_dictionary_record_handles_vector_info = true;
     }
-    m_dictionary_record_handles_vector_info = new dictionary_record_handles_vector_t(m__io, this, m__root);
+}
+
+column_data_dictionary_t::dictionary_record_handles_vector_t* column_data_dictionary_t::string_data_t::dictionary_record_handles_vector_info() {
+    if (f_dictionary_record_handles_vector_info)
+        return m_dictionary_record_handles_vector_info;
+    std::streampos _pos = m__io->pos();
+    m__io->seek(dictionary_record_handles_vector_info_ofs());
+    m_dictionary_record_handles_vector_info = m__root->_arena_new<dictionary_record_handles_vector_t>(m__io, this, m__root);
+    m__io->seek(_pos);
+    f_dictionary_record_handles_vector_info = true;
+    return m_dictionary_record_handles_vector_info;
 }
 
 column_data_dictionary_t::string_data_t::~string_data_t() {
@@ -108,18 +117,6 @@ column_data_dictionary_t::string_data_t::~string_data_t() {
 }
 
 void column_data_dictionary_t::string_data_t::_clean_up() {
-    if (m_page_layout_information) {
-        delete m_page_layout_information; m_page_layout_information = 0;
-    }
-    if (m_dictionary_pages) {
-        for (std::vector<dictionary_page_t*>::iterator it = m_dictionary_pages->begin(); it != m_dictionary_pages->end(); ++it) {
-            delete *it;
-        }
-        delete m_dictionary_pages; m_dictionary_pages = 0;
-    }
-    if (m_dictionary_record_handles_vector_info) {
-        delete m_dictionary_record_handles_vector_info; m_dictionary_record_handles_vector_info = 0;
-    }
 }
 
 column_data_dictionary_t::hash_info_t::hash_info_t(kaitai::kstream* p__io, column_data_dictionary_t* p__parent, column_data_dictionary_t* p__root) : kaitai::kstruct(p__io) {
@@ -136,7 +133,7 @@ column_data_dictionary_t::hash_info_t::hash_info_t(kaitai::kstream* p__io, colum
 }
 
 void column_data_dictionary_t::hash_info_t::_read() {
-    m_hash_elements = new std::vector<int32_t>();
+    m_hash_elements = m__root->_arena_vector<int32_t>();
     const int l_hash_elements = 6;
     for (int i = 0; i < l_hash_elements; i++) {
         m_hash_elements->push_back(m__io->read_s4le());
@@ -148,15 +145,14 @@ column_data_dictionary_t::hash_info_t::~hash_info_t() {
 }
 
 void column_data_dictionary_t::hash_info_t::_clean_up() {
-    if (m_hash_elements) {
-        delete m_hash_elements; m_hash_elements = 0;
-    }
 }
 
 column_data_dictionary_t::vector_of_vectors_t::vector_of_vectors_t(kaitai::kstream* p__io, column_data_dictionary_t::number_data_t* p__parent, column_data_dictionary_t* p__root) : kaitai::kstruct(p__io) {
     m__parent = p__parent;
     m__root = p__root;
-    m_values = 0;
+    m_values_int32 = 0;
+    m_values_int64 = 0;
+    m_values_float64 = 0;
     f_is_int32 = false;
     f_is_int64 = false;
     f_is_float64 = false;
@@ -173,21 +169,25 @@ column_data_dictionary_t::vector_of_vectors_t::vector_of_vectors_t(kaitai::kstre
 void column_data_dictionary_t::vector_of_vectors_t::_read() {
     m_num_values = m__io->read_u8le();
     m_element_size = m__io->read_u4le();
-    m_values = new std::vector<double>();
-    const int l_values = num_values();
-    for (int i = 0; i < l_values; i++) {
-        {
-            std::string on = data_type_id();
-            if (on == std::string("int32")) {
-                m_values->push_back(m__io->read_s4le());
-            }
-            else if (on == std::string("int64")) {
-                m_values->push_back(m__io->read_s8le());
-            }
-            else if (on == std::string("float64")) {
-                m_values->push_back(m__io->read_f8le());
-            }
-        }
+    // The type is resolved once and the whole array is read in one go
+    const uint64_t l_values = num_values();
+    if (_root()->read_mode() == column_data_dictionary_t::READ_MODE_HEADERS) {
+        m__io->seek(m__io->pos() + l_values * element_size());
+        return;
+    }
+    std::string storage;
+    if (is_int32()) {
+        std::string_view raw = m__io->read_bytes_view(l_values * 4, storage);
+        m_values_int32 = m__root->_arena_vector<int32_t>(l_values);
+        copy_le(raw.data(), l_values, m_values_int32->data());
+    } else if (is_int64()) {
+        std::string_view raw = m__io->read_bytes_view(l_values * 8, storage);
+        m_values_int64 = m__root->_arena_vector<int64_t>(l_values);
+        copy_le(raw.data(), l_values, m_values_int64->data());
+    } else {
+        std::string_view raw = m__io->read_bytes_view(l_values * 8, storage);
+        m_values_float64 = m__root->_arena_vector<double>(l_values);
+        copy_le(raw.data(), l_values, m_values_float64->data());
     }
 }
 
@@ -196,9 +196,6 @@ column_data_dictionary_t::vector_of_vectors_t::~vector_of_vectors_t() {
 }
 
 void column_data_dictionary_t::vector_of_vectors_t::_clean_up() {
-    if (m_values) {
-        delete m_values; m_values = 0;
-    }
 }
 
 bool column_data_dictionary_t::vector_of_vectors_t::is_int32() {
@@ -228,7 +225,7 @@ bool column_data_dictionary_t::vector_of_vectors_t::is_float64() {
 std::string column_data_dictionary_t::vector_of_vectors_t::data_type_id() {
     if (f_data_type_id)
         return m_data_type_id;
-    m_data_type_id = ((is_int32()) ? (std::string("int32")) : (((is_int64()) ? (std::string("int64")) : (std::string("float64")))));
+    m_data_type_id = ((is_int32()) ? ("int32") : (((is_int64()) ? ("int64") : ("float64"))));
     f_data_type_id = true;
     return m_data_type_id;
 }
@@ -236,7 +233,6 @@ std::string column_data_dictionary_t::vector_of_vectors_t::data_type_id() {
 column_data_dictionary_t::compressed_strings_t::compressed_strings_t(kaitai::kstream* p__io, column_data_dictionary_t::dictionary_page_t* p__parent, column_data_dictionary_t* p__root) : kaitai::kstruct(p__io) {
     m__parent = p__parent;
     m__root = p__root;
-    m_encode_array = 0;
 
     try {
         _read();
@@ -252,13 +248,12 @@ void column_data_dictionary_t::compressed_strings_t::_read() {
     m_len_compressed_string_buffer = m__io->read_u8le();
     m_character_set_used = m__io->read_u1();
     m_ui_decode_bits = m__io->read_u4le();
-    m_encode_array = new std::vector<uint8_t>();
     const int l_encode_array = 128;
     for (int i = 0; i < l_encode_array; i++) {
-        m_encode_array->push_back(m__io->read_u1());
+        m_encode_array[i] = m__io->read_u1();
     }
     m_ui64_buffer_size = m__io->read_u8le();
-    m_compressed_string_buffer = m__io->read_bytes(len_compressed_string_buffer());
+    m_compressed_string_buffer = m__io->read_bytes_view(len_compressed_string_buffer(), m__root->_arena());
 }
 
 column_data_dictionary_t::compressed_strings_t::~compressed_strings_t() {
@@ -266,9 +261,6 @@ column_data_dictionary_t::compressed_strings_t::~compressed_strings_t() {
 }
 
 void column_data_dictionary_t::compressed_strings_t::_clean_up() {
-    if (m_encode_array) {
-        delete m_encode_array; m_encode_array = 0;
-    }
 }
 
 column_data_dictionary_t::page_layout_t::page_layout_t(kaitai::kstream* p__io, column_data_dictionary_t::string_data_t* p__parent, column_data_dictionary_t* p__root) : kaitai::kstruct(p__io) {
@@ -300,6 +292,10 @@ void column_data_dictionary_t::page_layout_t::_clean_up() {
 column_data_dictionary_t::dictionary_page_t::dictionary_page_t(kaitai::kstream* p__io, column_data_dictionary_t::string_data_t* p__parent, column_data_dictionary_t* p__root) : kaitai::kstruct(p__io) {
     m__parent = p__parent;
     m__root = p__root;
+    m_len_string_store_buffer = 0;
+    f_string_store = false;
+    m_string_store = 0;
+    n_string_store = true;
 
     try {
         _read();
@@ -315,39 +311,78 @@ void column_data_dictionary_t::dictionary_page_t::_read() {
     m_page_start_index = m__io->read_u8le();
     m_page_string_count = m__io->read_u8le();
     m_page_compressed = m__io->read_u1();
-    m_string_store_begin_mark = m__io->read_bytes(4);
+    m_string_store_begin_mark = m__io->read_bytes_view(4, m__root->_arena());
     if (!(string_store_begin_mark() == std::string("\xDD\xCC\xBB\xAA", 4))) {
         throw kaitai::validation_not_equal_error<std::string>(std::string("\xDD\xCC\xBB\xAA", 4), string_store_begin_mark(), _io(), std::string("/types/dictionary_page/seq/5"));
     }
+    m_string_store_ofs = m__io->pos();
+    if (_root()->read_mode() == column_data_dictionary_t::READ_MODE_EAGER) {
+        _read_string_store();
+        f_string_store = true;
+    } else {
+        _skip_string_store();
+    }
+    m_string_store_end_mark = m__io->read_bytes_view(4, m__root->_arena());
+    if (!(string_store_end_mark() == std::string("\xCD\xAB\xCD\xAB", 4))) {
+        throw kaitai::validation_not_equal_error<std::string>(std::string("\xCD\xAB\xCD\xAB", 4), string_store_end_mark(), _io(), std::string("/types/dictionary_page/seq/7"));
+    }
+}
+
+void column_data_dictionary_t::dictionary_page_t::_read_string_store() {
     n_string_store = true;
     switch (page_compressed()) {
     case 0: {
         n_string_store = false;
-        m_string_store = new uncompressed_strings_t(m__io, this, m__root);
+        uncompressed_strings_t* store = m__root->_arena_new<uncompressed_strings_t>(m__io, this, m__root);
+        m_string_store = store;
+        m_len_string_store_buffer = store->allocation_size();
         break;
     }
     case 1: {
         n_string_store = false;
-        m_string_store = new compressed_strings_t(m__io, this, m__root);
+        compressed_strings_t* store = m__root->_arena_new<compressed_strings_t>(m__io, this, m__root);
+        m_string_store = store;
+        m_len_string_store_buffer = store->len_compressed_string_buffer();
         break;
     }
     }
-    m_string_store_end_mark = m__io->read_bytes(4);
-    if (!(string_store_end_mark() == std::string("\xCD\xAB\xCD\xAB", 4))) {
-        throw kaitai::validation_not_equal_error<std::string>(std::string("\xCD\xAB\xCD\xAB", 4), string_store_end_mark(), _io(), std::string("/types/dictionary_page/seq/7"));
+}
+
+void column_data_dictionary_t::dictionary_page_t::_skip_string_store() {
+    // Only the buffer length field of the store is read; see uncompressed_strings
+    // and compressed_strings in dictionary.ksy for the fixed-size headers skipped here
+    switch (page_compressed()) {
+    case 0: {
+        m__io->seek(string_store_ofs() + 16);
+        m_len_string_store_buffer = m__io->read_u8le();
+        m__io->seek(string_store_ofs() + 24 + len_string_store_buffer());
+        break;
+    }
+    case 1: {
+        m__io->seek(string_store_ofs() + 8);
+        m_len_string_store_buffer = m__io->read_u8le();
+        m__io->seek(string_store_ofs() + 157 + len_string_store_buffer());
+        break;
+    }
     }
 }
 
+kaitai::kstruct* column_data_dictionary_t::dictionary_page_t::string_store() {
+    if (f_string_store)
+        return m_string_store;
+    std::streampos _pos = m__io->pos();
+    m__io->seek(string_store_ofs());
+    _read_string_store();
+    m__io->seek(_pos);
+    f_string_store = true;
+    return m_string_store;
+}
+
 column_data_dictionary_t::dictionary_page_t::~dictionary_page_t() {
     _clean_up();
 }
 
 void column_data_dictionary_t::dictionary_page_t::_clean_up() {
-    if (!n_string_store) {
-        if (m_string_store) {
-            delete m_string_store; m_string_store = 0;
-        }
-    }
 }
 
 column_data_dictionary_t::other_record_handle_t::other_record_handle_t(kaitai::kstream* p__io, kaitai::kstruct* p__parent, column_data_dictionary_t* p__root) : kaitai::kstruct(p__io) {
@@ -389,7 +424,11 @@ void column_data_dictionary_t::uncompressed_strings_t::_read() {
     m_remaining_store_available = m__io->read_u8le();
     m_buffer_used_characters = m__io->read_u8le();
     m_allocation_size = m__io->read_u8le();
-    m_uncompressed_character_buffer = kaitai::kstream::bytes_to_str(m__io->read_bytes(allocation_size()), "UTF-16LE");
+    m_uncompressed_character_bytes = m__io->read_bytes_view(allocation_size(), m__root->_arena());
+}
+
+std::string column_data_dictionary_t::uncompressed_strings_t::uncompressed_character_buffer() const {
+    return kaitai::kstream::bytes_to_str(std::string(m_uncompressed_character_bytes), "UTF-16LE");
 }
 
 column_data_dictionary_t::uncompressed_strings_t::~uncompressed_strings_t() {
@@ -413,7 +452,7 @@ column_data_dictionary_t::number_data_t::number_data_t(kaitai::kstream* p__io, c
 }
 
 void column_data_dictionary_t::number_data_t::_read() {
-    m_vector_of_vectors_info = new vector_of_vectors_t(m__io, this, m__root);
+    m_vector_of_vectors_info = m__root->_arena_new<vector_of_vectors_t>(m__io, this, m__root);
 }
 
 column_data_dictionary_t::number_data_t::~number_data_t() {
@@ -421,9 +460,6 @@ column_data_dictionary_t::number_data_t::~number_data_t() {
 }
 
 void column_data_dictionary_t::number_data_t::_clean_up() {
-    if (m_vector_of_vectors_info) {
-        delete m_vector_of_vectors_info; m_vector_of_vectors_info = 0;
-    }
 }
 
 column_data_dictionary_t::dictionary_record_handles_vector_t::dictionary_record_handles_vector_t(kaitai::kstream* p__io, column_data_dictionary_t::string_data_t* p__parent, column_data_dictionary_t* p__root) : kaitai::kstruct(p__io) {
@@ -441,14 +477,20 @@ column_data_dictionary_t::dictionary_record_handles_vector_t::dictionary_record_
 
 void column_data_dictionary_t::dictionary_record_handles_vector_t::_read() {
     m_num_vector_of_record_handle_structures = m__io->read_u8le();
-    m_element_size = m__io->read_bytes(4);
+    m_element_size = m__io->read_bytes_view(4, m__root->_arena());
     if (!(element_size() == std::string("\x08\x00\x00\x00", 4))) {
         throw kaitai::validation_not_equal_error<std::string>(std::string("\x08\x00\x00\x00", 4), element_size(), _io(), std::string("/types/dictionary_record_handles_vector/seq/1"));
     }
-    m_vector_of_record_handle_structures = new std::vector<string_record_handle_t*>();
-    const int l_vector_of_record_handle_structures = num_vector_of_record_handle_structures();
-    for (int i = 0; i < l_vector_of_record_handle_structures; i++) {
-        m_vector_of_record_handle_structures->push_back(new string_record_handle_t(m__io, this, m__root));
+    // One bulk read of the whole vector, decoded as u4le pairs in a single pass
+    const uint64_t l_vector_of_record_handle_structures = num_vector_of_record_handle_structures();
+    std::string storage;
+    std::string_view raw = m__io->read_bytes_view(l_vector_of_record_handle_structures * 8, storage);
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(raw.data());
+    m_vector_of_record_handle_structures = m__root->_arena_vector<string_record_handle_t>(l_vector_of_record_handle_structures);
+    for (uint64_t i = 0; i < l_vector_of_record_handle_structures; i++, p += 8) {
+        string_record_handle_t& handle = (*m_vector_of_record_handle_structures)[i];
+        handle.m_bit_or_byte_offset = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+        handle.m_page_id = p[4] | (p[5] << 8) | (p[6] << 16) | (static_cast<uint32_t>(p[7]) << 24);
     }
 }
 
@@ -457,10 +499,4 @@ column_data_dictionary_t::dictionary_record_handles_vector_t::~dictionary_record
 }
 
 void column_data_dictionary_t::dictionary_record_handles_vector_t::_clean_up() {
-    if (m_vector_of_record_handle_structures) {
-        for (std::vector<string_record_handle_t*>::iterator it = m_vector_of_record_handle_structures->begin(); it != m_vector_of_record_handle_structures->end(); ++it) {
-            delete *it;
-        }
-        delete m_vector_of_record_handle_structures; m_vector_of_record_handle_structures = 0;
-    }
 }
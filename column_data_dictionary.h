@@ -1,10 +1,22 @@
 #ifndef COLUMN_DATA_DICTIONARY_H_
 #define COLUMN_DATA_DICTIONARY_H_
 
-// This is a generated file! Please edit source .ksy file and use kaitai-struct-compiler to rebuild
+// Generated from dictionary.ksy by kaitai-struct-compiler, then extended by hand:
+// page buffers are exposed as views into a memory-backed kstream (zero-copy),
+// READ_MODE_LAZY defers string stores and record handles until first access,
+// READ_MODE_HEADERS additionally skips numeric values,
+// record handles and numeric values are bulk-read into flat, typed arrays, and
+// every node and array is allocated from a per-dictionary arena owned by the root.
+// Regenerating from the .ksy will drop these changes.
 
 #include "kaitai/kaitaistruct.h"
 #include <stdint.h>
+#include <array>
+#include <memory_resource>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 #if KAITAI_STRUCT_VERSION < 9000L
@@ -33,7 +45,19 @@ public:
         DICTIONARY_TYPES_XM_TYPE_STRING = 2
     };
 
-    column_data_dictionary_t(kaitai::kstream* p__io, kaitai::kstruct* p__parent = 0, column_data_dictionary_t* p__root = 0);
+    // READ_MODE_LAZY only parses page headers: each page's string store and the
+    // record handle vector are skipped by seeking and read from the stream on
+    // first access. Lazy accessors are not thread-safe.
+    // READ_MODE_HEADERS is READ_MODE_LAZY that also seeks past the values of a
+    // numeric dictionary, which are then never read: values_int32() and its
+    // siblings return null. Only counts, sizes and flags are read from the stream.
+    enum read_mode_t {
+        READ_MODE_EAGER = 0,
+        READ_MODE_LAZY = 1,
+        READ_MODE_HEADERS = 2
+    };
+
+    column_data_dictionary_t(kaitai::kstream* p__io, kaitai::kstruct* p__parent = 0, column_data_dictionary_t* p__root = 0, read_mode_t p_read_mode = READ_MODE_EAGER);
 
 private:
     void _read();
@@ -42,30 +66,33 @@ private:
 public:
     ~column_data_dictionary_t();
 
-    class string_record_handle_t : public kaitai::kstruct {
-
-    public:
-
-        string_record_handle_t(kaitai::kstream* p__io, column_data_dictionary_t::dictionary_record_handles_vector_t* p__parent = 0, column_data_dictionary_t* p__root = 0);
-
-    private:
-        void _read();
-        void _clean_up();
-
-    public:
-        ~string_record_handle_t();
+    // Nodes of the tree, the element buffers of their vectors and the byte
+    // buffers read from istream-backed streams all live in the root's
+    // monotonic arena: parsing is bump-pointer allocation, and as no node
+    // holds anything else, the tree is released at once with the root
+    // without running a destructor per node.
+    template <typename T, typename... Args>
+    T* _arena_new(Args&&... args) {
+        return new (m_arena.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+    template <typename T>
+    std::pmr::vector<T>* _arena_vector(size_t size = 0) {
+        return _arena_new<std::pmr::vector<T>>(size, &m_arena);
+    }
+    std::pmr::memory_resource* _arena() { return &m_arena; }
+
+    // Plain 8-byte record handle. The handle vector is bulk-read into one
+    // contiguous array of these instead of one heap-allocated kstruct per string.
+    class string_record_handle_t {
+        friend class dictionary_record_handles_vector_t;
 
     private:
         uint32_t m_bit_or_byte_offset;
         uint32_t m_page_id;
-        column_data_dictionary_t* m__root;
-        column_data_dictionary_t::dictionary_record_handles_vector_t* m__parent;
 
     public:
         uint32_t bit_or_byte_offset() const { return m_bit_or_byte_offset; }
         uint32_t page_id() const { return m_page_id; }
-        column_data_dictionary_t* _root() const { return m__root; }
-        column_data_dictionary_t::dictionary_record_handles_vector_t* _parent() const { return m__parent; }
     };
 
     class string_data_t : public kaitai::kstruct {
@@ -83,15 +110,19 @@ public:
 
     private:
         page_layout_t* m_page_layout_information;
-        std::vector<dictionary_page_t*>* m_dictionary_pages;
+        std::pmr::vector<dictionary_page_t*>* m_dictionary_pages;
+        uint64_t m_dictionary_record_handles_vector_info_ofs;
+        bool f_dictionary_record_handles_vector_info;
         dictionary_record_handles_vector_t* m_dictionary_record_handles_vector_info;
         column_data_dictionary_t* m__root;
         column_data_dictionary_t* m__parent;
 
     public:
         page_layout_t* page_layout_information() const { return m_page_layout_information; }
-        std::vector<dictionary_page_t*>* dictionary_pages() const { return m_dictionary_pages; }
-        dictionary_record_handles_vector_t* dictionary_record_handles_vector_info() const { return m_dictionary_record_handles_vector_info; }
+        std::pmr::vector<dictionary_page_t*>* dictionary_pages() const { return m_dictionary_pages; }
+        // Stream offset of the record handle vector, known without reading it
+        uint64_t dictionary_record_handles_vector_info_ofs() const { return m_dictionary_record_handles_vector_info_ofs; }
+        dictionary_record_handles_vector_t* dictionary_record_handles_vector_info();
         column_data_dictionary_t* _root() const { return m__root; }
         column_data_dictionary_t* _parent() const { return m__parent; }
     };
@@ -110,12 +141,12 @@ public:
         ~hash_info_t();
 
     private:
-        std::vector<int32_t>* m_hash_elements;
+        std::pmr::vector<int32_t>* m_hash_elements;
         column_data_dictionary_t* m__root;
         column_data_dictionary_t* m__parent;
 
     public:
-        std::vector<int32_t>* hash_elements() const { return m_hash_elements; }
+        std::pmr::vector<int32_t>* hash_elements() const { return m_hash_elements; }
         column_data_dictionary_t* _root() const { return m__root; }
         column_data_dictionary_t* _parent() const { return m__parent; }
     };
@@ -156,7 +187,7 @@ public:
 
     private:
         bool f_data_type_id;
-        std::string m_data_type_id;
+        const char* m_data_type_id;
 
     public:
         std::string data_type_id();
@@ -164,14 +195,20 @@ public:
     private:
         uint64_t m_num_values;
         uint32_t m_element_size;
-        std::vector<double>* m_values;
+        std::pmr::vector<int32_t>* m_values_int32;
+        std::pmr::vector<int64_t>* m_values_int64;
+        std::pmr::vector<double>* m_values_float64;
         column_data_dictionary_t* m__root;
         column_data_dictionary_t::number_data_t* m__parent;
 
     public:
         uint64_t num_values() const { return m_num_values; }
         uint32_t element_size() const { return m_element_size; }
-        std::vector<double>* values() const { return m_values; }
+        // Values in their stored type: exactly one of these is non-null, selected
+        // by is_int32() / is_int64() / is_float64(). All are null in READ_MODE_HEADERS.
+        std::pmr::vector<int32_t>* values_int32() const { return m_values_int32; }
+        std::pmr::vector<int64_t>* values_int64() const { return m_values_int64; }
+        std::pmr::vector<double>* values_float64() const { return m_values_float64; }
         column_data_dictionary_t* _root() const { return m__root; }
         column_data_dictionary_t::number_data_t* _parent() const { return m__parent; }
     };
@@ -195,9 +232,9 @@ public:
         uint64_t m_len_compressed_string_buffer;
         uint8_t m_character_set_used;
         uint32_t m_ui_decode_bits;
-        std::vector<uint8_t>* m_encode_array;
+        std::array<uint8_t, 128> m_encode_array;
         uint64_t m_ui64_buffer_size;
-        std::string m_compressed_string_buffer;
+        std::string_view m_compressed_string_buffer;
         column_data_dictionary_t* m__root;
         column_data_dictionary_t::dictionary_page_t* m__parent;
 
@@ -207,9 +244,10 @@ public:
         uint64_t len_compressed_string_buffer() const { return m_len_compressed_string_buffer; }
         uint8_t character_set_used() const { return m_character_set_used; }
         uint32_t ui_decode_bits() const { return m_ui_decode_bits; }
-        std::vector<uint8_t>* encode_array() const { return m_encode_array; }
+        const std::array<uint8_t, 128>* encode_array() const { return &m_encode_array; }
         uint64_t ui64_buffer_size() const { return m_ui64_buffer_size; }
-        std::string compressed_string_buffer() const { return m_compressed_string_buffer; }
+        // View into the memory-backed stream, or into a copy in the arena for istream-backed streams
+        std::string_view compressed_string_buffer() const { return m_compressed_string_buffer; }
         column_data_dictionary_t* _root() const { return m__root; }
         column_data_dictionary_t::dictionary_page_t* _parent() const { return m__parent; }
     };
@@ -252,6 +290,8 @@ public:
 
     private:
         void _read();
+        void _read_string_store();
+        void _skip_string_store();
         void _clean_up();
 
     public:
@@ -263,7 +303,10 @@ public:
         uint64_t m_page_start_index;
         uint64_t m_page_string_count;
         uint8_t m_page_compressed;
-        std::string m_string_store_begin_mark;
+        std::string_view m_string_store_begin_mark;
+        uint64_t m_string_store_ofs;
+        uint64_t m_len_string_store_buffer;
+        bool f_string_store;
         kaitai::kstruct* m_string_store;
         bool n_string_store;
 
@@ -271,7 +314,7 @@ public:
         bool _is_null_string_store() { string_store(); return n_string_store; };
 
     private:
-        std::string m_string_store_end_mark;
+        std::string_view m_string_store_end_mark;
         column_data_dictionary_t* m__root;
         column_data_dictionary_t::string_data_t* m__parent;
 
@@ -281,9 +324,14 @@ public:
         uint64_t page_start_index() const { return m_page_start_index; }
         uint64_t page_string_count() const { return m_page_string_count; }
         uint8_t page_compressed() const { return m_page_compressed; }
-        std::string string_store_begin_mark() const { return m_string_store_begin_mark; }
-        kaitai::kstruct* string_store() const { return m_string_store; }
-        std::string string_store_end_mark() const { return m_string_store_end_mark; }
+        std::string string_store_begin_mark() const { return std::string(m_string_store_begin_mark); }
+        // Stream offset of the string store and size of its character/bit buffer in
+        // bytes; both are known without reading the store
+        uint64_t string_store_ofs() const { return m_string_store_ofs; }
+        uint64_t len_string_store_buffer() const { return m_len_string_store_buffer; }
+        bool _is_loaded_string_store() const { return f_string_store; }
+        kaitai::kstruct* string_store();
+        std::string string_store_end_mark() const { return std::string(m_string_store_end_mark); }
         column_data_dictionary_t* _root() const { return m__root; }
         column_data_dictionary_t::string_data_t* _parent() const { return m__parent; }
     };
@@ -329,7 +377,7 @@ public:
         uint64_t m_remaining_store_available;
         uint64_t m_buffer_used_characters;
         uint64_t m_allocation_size;
-        std::string m_uncompressed_character_buffer;
+        std::string_view m_uncompressed_character_bytes;
         column_data_dictionary_t* m__root;
         column_data_dictionary_t::dictionary_page_t* m__parent;
 
@@ -337,7 +385,12 @@ public:
         uint64_t remaining_store_available() const { return m_remaining_store_available; }
         uint64_t buffer_used_characters() const { return m_buffer_used_characters; }
         uint64_t allocation_size() const { return m_allocation_size; }
-        std::string uncompressed_character_buffer() const { return m_uncompressed_character_buffer; }
+        // Raw UTF-16LE buffer, a view like compressed_strings_t::compressed_string_buffer()
+        std::string_view uncompressed_character_bytes() const { return m_uncompressed_character_bytes; }
+        // The part of the raw buffer holding strings, without the allocation padding
+        std::string_view used_character_bytes() const { return m_uncompressed_character_bytes.substr(0, buffer_used_characters() * 2); }
+        // UTF-8 conversion of the raw buffer, converted on every call
+        std::string uncompressed_character_buffer() const;
         column_data_dictionary_t* _root() const { return m__root; }
         column_data_dictionary_t::dictionary_page_t* _parent() const { return m__parent; }
     };
@@ -381,20 +434,22 @@ public:
 
     private:
         uint64_t m_num_vector_of_record_handle_structures;
-        std::string m_element_size;
-        std::vector<string_record_handle_t*>* m_vector_of_record_handle_structures;
+        std::string_view m_element_size;
+        std::pmr::vector<string_record_handle_t>* m_vector_of_record_handle_structures;
         column_data_dictionary_t* m__root;
         column_data_dictionary_t::string_data_t* m__parent;
 
     public:
         uint64_t num_vector_of_record_handle_structures() const { return m_num_vector_of_record_handle_structures; }
-        std::string element_size() const { return m_element_size; }
-        std::vector<string_record_handle_t*>* vector_of_record_handle_structures() const { return m_vector_of_record_handle_structures; }
+        std::string element_size() const { return std::string(m_element_size); }
+        std::pmr::vector<string_record_handle_t>* vector_of_record_handle_structures() const { return m_vector_of_record_handle_structures; }
         column_data_dictionary_t* _root() const { return m__root; }
         column_data_dictionary_t::string_data_t* _parent() const { return m__parent; }
     };
 
 private:
+    std::pmr::monotonic_buffer_resource m_arena;
+    read_mode_t m_read_mode;
     dictionary_types_t m_dictionary_type;
     hash_info_t* m_hash_information;
     kaitai::kstruct* m_data;
@@ -408,6 +463,7 @@ private:
     kaitai::kstruct* m__parent;
 
 public:
+    read_mode_t read_mode() const { return m_read_mode; }
     dictionary_types_t dictionary_type() const { return m_dictionary_type; }
     hash_info_t* hash_information() const { return m_hash_information; }
     kaitai::kstruct* data() const { return m_data; }
@@ -0,0 +1,287 @@
+#include "column_segment.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+#include "arrow_writer.h"
+#include "mapped_file.h"
+#include "stats.h"
+
+namespace {
+
+// Copy `count` little-endian elements of type T from src into out
+template <typename T>
+void copy_le(const char* src, uint64_t count, T* out) {
+    std::memcpy(out, src, count * sizeof(T));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    char* bytes = reinterpret_cast<char*>(out);
+    for (uint64_t i = 0; i < count; i++, bytes += sizeof(T)) {
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+#endif
+}
+
+// Bounds-checked reader over the mapped .idf file
+class SegmentCursor {
+public:
+    SegmentCursor(std::string_view bytes, const std::string& path) : m_bytes(bytes), m_path(path) {}
+
+    bool at_end() const { return m_pos == m_bytes.size(); }
+
+    const char* take(uint64_t size) {
+        if (size > m_bytes.size() - m_pos) {
+            throw std::runtime_error(m_path + " is truncated at byte " + std::to_string(m_pos));
+        }
+        const char* p = m_bytes.data() + m_pos;
+        m_pos += size;
+        return p;
+    }
+
+    // Element count followed by `element_size` bytes per element
+    uint64_t count(uint64_t element_size) {
+        uint64_t n;
+        copy_le(take(8), 1, &n);
+        if (n > (m_bytes.size() - m_pos) / element_size) {
+            throw std::runtime_error(m_path + " is truncated at byte " + std::to_string(m_pos));
+        }
+        return n;
+    }
+
+private:
+    std::string_view m_bytes;
+    const std::string& m_path;
+    size_t m_pos = 0;
+};
+
+// One kernel per bit width: the inner loop has a fixed trip count, so it is
+// unrolled and vectorized with per-lane shifts
+template <uint32_t W>
+void unpack_words(const uint64_t* words, size_t word_count, uint32_t base, uint32_t* out) {
+    constexpr uint32_t per_word = 64 / W;
+    constexpr uint64_t mask = (uint64_t(1) << W) - 1;
+    for (size_t w = 0; w < word_count; w++, out += per_word) {
+        const uint64_t word = words[w];
+        for (uint32_t k = 0; k < per_word; k++) {
+            out[k] = base + static_cast<uint32_t>((word >> (k * W)) & mask);
+        }
+    }
+}
+
+using UnpackKernel = void (*)(const uint64_t*, size_t, uint32_t, uint32_t*);
+
+template <size_t... W>
+constexpr std::array<UnpackKernel, sizeof...(W)> unpack_kernels(std::index_sequence<W...>) {
+    return {{&unpack_words<W + 1>...}};
+}
+
+constexpr std::array<UnpackKernel, 32> kUnpackKernels = unpack_kernels(std::make_index_sequence<32>());
+
+// Every value of a dictionary, decoded once and indexed by position
+struct DictionaryValues {
+    std::string bytes;
+    std::vector<uint64_t> ends;
+
+    uint64_t size() const { return ends.size(); }
+    std::string_view operator[](uint64_t i) const {
+        const uint64_t begin = i ? ends[i - 1] : 0;
+        return std::string_view(bytes.data() + begin, ends[i] - begin);
+    }
+};
+
+DictionaryValues collect_values(DictionaryReader& dictionary) {
+    DictionaryValues values;
+    values.ends.reserve(dictionary.size());
+    dictionary.for_each([&values](uint64_t, std::string_view value) {
+        values.bytes.append(value.data(), value.size());
+        values.ends.push_back(values.bytes.size());
+    });
+    return values;
+}
+
+// Dictionary position of a data ID, or `size` for a blank row
+uint64_t position(uint32_t data_id, uint64_t first_data_id, uint64_t size) {
+    return data_id >= first_data_id && data_id - first_data_id < size ? data_id - first_data_id : size;
+}
+
+template <typename T>
+std::vector<T> gather(const std::pmr::vector<T>& dictionary, const std::vector<uint32_t>& data_ids, uint64_t first_data_id,
+                      uint64_t& blank) {
+    std::vector<T> column(data_ids.size());
+    for (size_t row = 0; row < data_ids.size(); row++) {
+        const uint64_t i = position(data_ids[row], first_data_id, dictionary.size());
+        if (i < dictionary.size()) {
+            column[row] = dictionary[i];
+        } else {
+            column[row] = T();
+            blank++;
+        }
+    }
+    return column;
+}
+
+} // namespace
+
+std::vector<ColumnSegment> read_column_segments(const std::string& path) {
+    Stats::Timer open_timer(Stats::kOpen);
+    MappedFile file;
+    if (!file.open(path)) {
+        throw std::runtime_error("Error opening file: " + path);
+    }
+    open_timer.stop();
+
+    Stats::Timer parse_timer(Stats::kParse);
+    SegmentCursor cursor(file.view(), path);
+    std::vector<ColumnSegment> segments;
+    while (!cursor.at_end()) {
+        ColumnSegment segment;
+        const uint64_t run_count = cursor.count(8);
+        const char* runs = cursor.take(run_count * 8);
+        segment.runs.resize(run_count);
+        for (uint64_t i = 0; i < run_count; i++) {
+            copy_le(runs + i * 8, 1, &segment.runs[i].data_value);
+            copy_le(runs + i * 8 + 4, 1, &segment.runs[i].repeat_value);
+        }
+        const uint64_t word_count = cursor.count(8);
+        segment.words.resize(word_count);
+        copy_le(cursor.take(word_count * 8), word_count, segment.words.data());
+        segments.push_back(std::move(segment));
+    }
+    return segments;
+}
+
+void unpack_bits(const uint64_t* words, size_t word_count, uint32_t bit_width, uint32_t min_data_id, uint32_t* out) {
+    if (bit_width == 0 || bit_width > kUnpackKernels.size()) {
+        throw std::runtime_error("unsupported bit width " + std::to_string(bit_width));
+    }
+    kUnpackKernels[bit_width - 1](words, word_count, min_data_id, out);
+}
+
+std::vector<uint32_t> decode_data_ids(const std::vector<ColumnSegment>& segments, const SegmentLayout& layout) {
+    Stats::Timer timer(Stats::kDecode);
+    if (layout.bit_width == 0 || layout.bit_width > 32) {
+        throw std::runtime_error("unsupported bit width " + std::to_string(layout.bit_width));
+    }
+    const size_t per_word = 64 / layout.bit_width;
+    if (!layout.segment_rows.empty() && layout.segment_rows.size() != segments.size()) {
+        throw std::runtime_error(std::to_string(layout.segment_rows.size()) + " segment row counts for " +
+                                 std::to_string(segments.size()) + " segments");
+    }
+
+    std::vector<uint32_t> data_ids;
+    std::vector<uint32_t> packed;
+    for (size_t s = 0; s < segments.size(); s++) {
+        const ColumnSegment& segment = segments[s];
+        packed.resize(segment.words.size() * per_word);
+        unpack_bits(segment.words.data(), segment.words.size(), layout.bit_width, layout.min_data_id, packed.data());
+        if (segment.runs.empty()) {
+            // The last word is padded: trimmed here with the segment's row
+            // count, or for the last segment below with layout.rows
+            size_t rows = packed.size();
+            if (!layout.segment_rows.empty()) {
+                if (layout.segment_rows[s] > packed.size()) {
+                    throw std::runtime_error("segment " + std::to_string(s) + " has " + std::to_string(layout.segment_rows[s]) +
+                                             " rows, it has " + std::to_string(packed.size()) + " bit-packed values");
+                }
+                rows = layout.segment_rows[s];
+            } else if (s + 1 < segments.size()) {
+                throw std::runtime_error("segment " + std::to_string(s) + " is bit-packed as a whole and not the last; "
+                                         "its row count is needed to drop its padding");
+            }
+            data_ids.insert(data_ids.end(), packed.begin(), packed.begin() + rows);
+            continue;
+        }
+
+        uint64_t total = 0;
+        for (const SegmentRun& run : segment.runs) {
+            total += run.repeat_value;
+        }
+        size_t row = data_ids.size();
+        data_ids.resize(row + total);
+        uint32_t consumed = 0;  // bit-packed values taken by earlier runs
+        for (const SegmentRun& run : segment.runs) {
+            if (run.data_value + consumed == 0xFFFFFFFFu) {
+                if (run.repeat_value > packed.size() - consumed) {
+                    throw std::runtime_error("segment " + std::to_string(s) + " refers to " +
+                                             std::to_string(consumed + uint64_t(run.repeat_value)) + " bit-packed values, it has " +
+                                             std::to_string(packed.size()));
+                }
+                std::memcpy(&data_ids[row], packed.data() + consumed, run.repeat_value * sizeof(uint32_t));
+                consumed += run.repeat_value;
+            } else {
+                std::fill_n(data_ids.begin() + row, run.repeat_value, run.data_value);
+            }
+            row += run.repeat_value;
+        }
+    }
+    // The last word of a last segment without primary entries is padded
+    if (layout.rows && data_ids.size() > layout.rows) {
+        data_ids.resize(layout.rows);
+    }
+    return data_ids;
+}
+
+uint64_t materialize_column(DictionaryReader& dictionary, const std::vector<uint32_t>& data_ids,
+                            uint64_t first_data_id, OutputWriter& writer) {
+    const DictionaryValues values = collect_values(dictionary);
+    Stats::Timer timer(Stats::kOutput);
+    uint64_t blank = 0;
+    for (size_t row = 0; row < data_ids.size(); row++) {
+        const uint64_t i = position(data_ids[row], first_data_id, values.size());
+        if (i < values.size()) {
+            writer.write_record(row, values[i]);
+        } else {
+            writer.write_record(row, std::string_view());
+            blank++;
+        }
+    }
+    writer.flush();
+    return blank;
+}
+
+uint64_t materialize_column_arrow(DictionaryReader& dictionary, const std::vector<uint32_t>& data_ids,
+                                  uint64_t first_data_id, const std::string& name, OutputWriter& writer) {
+    ArrowWriter arrow(writer);
+    uint64_t blank = 0;
+    if (!dictionary.is_string()) {
+        auto number_data = static_cast<column_data_dictionary_t::number_data_t*>(dictionary.dictionary().data());
+        auto vector_info = number_data->vector_of_vectors_info();
+        Stats::Timer timer(Stats::kOutput);
+        if (vector_info->is_int32()) {
+            const std::vector<int32_t> column = gather(*vector_info->values_int32(), data_ids, first_data_id, blank);
+            arrow.write_int32(name, column.data(), column.size());
+        } else if (vector_info->is_int64()) {
+            const std::vector<int64_t> column = gather(*vector_info->values_int64(), data_ids, first_data_id, blank);
+            arrow.write_int64(name, column.data(), column.size());
+        } else {
+            const std::vector<double> column = gather(*vector_info->values_float64(), data_ids, first_data_id, blank);
+            arrow.write_float64(name, column.data(), column.size());
+        }
+        writer.flush();
+        return blank;
+    }
+
+    const DictionaryValues values = collect_values(dictionary);
+    Stats::Timer timer(Stats::kOutput);
+    std::vector<int64_t> offsets(data_ids.size() + 1);
+    std::vector<uint64_t> rows(data_ids.size());
+    for (size_t row = 0; row < data_ids.size(); row++) {
+        rows[row] = position(data_ids[row], first_data_id, values.size());
+        const uint64_t size = rows[row] < values.size() ? values[rows[row]].size() : 0;
+        blank += rows[row] == values.size();
+        offsets[row + 1] = offsets[row] + static_cast<int64_t>(size);
+    }
+    std::string data(static_cast<size_t>(offsets.back()), '\0');
+    for (size_t row = 0; row < rows.size(); row++) {
+        if (rows[row] < values.size()) {
+            std::string_view value = values[rows[row]];
+            std::memcpy(&data[offsets[row]], value.data(), value.size());
+        }
+    }
+    arrow.write_strings(name, data, offsets);
+    writer.flush();
+    return blank;
+}
@@ -0,0 +1,80 @@
+#ifndef COLUMN_SEGMENT_H_
+#define COLUMN_SEGMENT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "dictionary_reader.h"
+#include "output_writer.h"
+
+// Reading the rows of a column from its .idf file (2.3.1 Column Data Storage
+// in MS-XLDM) and materializing them through the column's dictionary.
+//
+// An .idf file is a sequence of segments, each made of a primary segment of
+// (data_value, repeat_value) u4 pairs and a sub segment of u8 words holding
+// bit-packed data IDs:
+//
+//   u8 primary_count, primary_count * {u4 data_value, u4 repeat_value}
+//   u8 sub_count,     sub_count * u8 word
+//
+// A primary entry is either an RLE run (repeat_value copies of data_value) or,
+// when data_value + (bit-packed values consumed so far) == 0xFFFFFFFF, a
+// reference to the next repeat_value values of the sub segment. A segment
+// without primary entries is bit-packed as a whole. Words are unpacked from
+// the least significant bits up, 64 / bit_width values per word.
+
+// One entry of a primary segment
+struct SegmentRun {
+    uint32_t data_value;
+    uint32_t repeat_value;
+};
+
+struct ColumnSegment {
+    std::vector<SegmentRun> runs;
+    std::vector<uint64_t> words;  // bit-packed sub segment
+};
+
+// How data IDs are stored and map to dictionary positions. None of this is in
+// the .idf file: the bit width and minimum data ID come from the column's
+// .idfmeta, the data ID of the first dictionary value from the column's
+// storage information.
+struct SegmentLayout {
+    uint32_t bit_width = 0;     // bits per bit-packed value, 1 to 32
+    uint32_t min_data_id = 0;   // added to every bit-packed value
+    uint64_t first_data_id = 0; // data ID of dictionary value 0
+    uint64_t rows = 0;          // rows of the column, 0 keeps every decoded value
+    // Rows of each segment, empty if unknown. The last word of a segment
+    // without primary entries is padded, so without these counts only the
+    // last segment may be one.
+    std::vector<uint64_t> segment_rows;
+};
+
+// Every segment of an .idf file. Throws std::runtime_error if the file cannot
+// be opened or is shorter than its counts say.
+std::vector<ColumnSegment> read_column_segments(const std::string& path);
+
+// Unpack `word_count` words of bit_width-bit values, adding min_data_id to
+// each. Writes word_count * (64 / bit_width) values to out.
+void unpack_bits(const uint64_t* words, size_t word_count, uint32_t bit_width, uint32_t min_data_id, uint32_t* out);
+
+// Data IDs of the rows of the segments, in row order, truncated to
+// layout.rows when it is set. Throws std::runtime_error on a run that points
+// past the bit-packed values, an unsupported bit width, segment row counts
+// that do not fit the segments, or a segment without primary entries before
+// the last one when they are not given.
+std::vector<uint32_t> decode_data_ids(const std::vector<ColumnSegment>& segments, const SegmentLayout& layout);
+
+// Write the dictionary value of every data ID to writer as a record with the
+// row number as its ID, and flush it. Data IDs outside the dictionary (blank
+// rows) are written as empty values. Returns the number of such rows.
+uint64_t materialize_column(DictionaryReader& dictionary, const std::vector<uint32_t>& data_ids,
+                            uint64_t first_data_id, OutputWriter& writer);
+
+// The same as one Arrow IPC file column named `name`, typed like the
+// dictionary (see ArrowWriter); blank rows are empty strings or 0.
+uint64_t materialize_column_arrow(DictionaryReader& dictionary, const std::vector<uint32_t>& data_ids,
+                                  uint64_t first_data_id, const std::string& name, OutputWriter& writer);
+
+#endif  // COLUMN_SEGMENT_H_
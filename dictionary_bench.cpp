@@ -0,0 +1,372 @@
+// Throughput benchmark of every phase of reading a dictionary: file read,
+// kaitai parse, Huffman code generation, tree and table build, decode and
+// output. Runs over .dictionary files (data/ by default) and over synthetic
+// dictionaries written by StringDictionaryWriter, and prints the results as JSON.
+//
+//   dictionary_bench [--repeat N] [--cold] [--synthetic N] [--synthetic-length L]
+//                    [--synthetic-page-strings N] [--synthetic-out PATH] [--seed S] [paths...]
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "kaitai/kaitaistream.h"
+#include "batch.h"
+#include "column_data_dictionary.h"
+#include "dictionary_reader.h"
+#include "dictionary_writer.h"
+#include "huffman.h"
+#include "mapped_file.h"
+#include "output_writer.h"
+#include "page_decoder.h"
+#include "stats.h"
+
+namespace {
+
+struct BenchOptions {
+    size_t repeat = 5;
+    bool cold = false;                 // drop the file from the page cache before each read/parse run
+    uint64_t synthetic_strings = 0;    // 0 = no synthetic run
+    size_t synthetic_length = 16;      // mean string length
+    uint32_t seed = 1;
+    uint64_t synthetic_page_strings = WriterOptions().page_strings;
+    std::string synthetic_path;        // keep the synthetic dictionary here, empty = temporary file
+};
+
+struct Phase {
+    std::string name;
+    uint64_t input_bytes = 0;
+    uint64_t output_bytes = 0;
+    uint64_t strings = 0;
+    std::vector<double> seconds;
+};
+
+struct Result {
+    std::string name;
+    std::string kind;
+    uint64_t bytes = 0;
+    uint64_t strings = 0;
+    std::vector<Phase> phases;
+};
+
+#ifdef _WIN32
+const char* kNullDevice = "NUL";
+void drop_cache(const std::string&) {}
+#else
+const char* kNullDevice = "/dev/null";
+// Ask the kernel to forget the file's cached pages so the next read goes to disk
+void drop_cache(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+}
+#endif
+
+// Bumped whenever the layout of the JSON report changes
+const int kJsonVersion = 1;
+
+// Keeps the optimizer from dropping work whose result is otherwise unused
+volatile uint64_t sink;
+
+template <typename F>
+Phase run_phase(const std::string& name, size_t repeat, uint64_t input_bytes, uint64_t strings, F&& f,
+                const std::function<void()>& before_each = nullptr) {
+    Phase phase{name, input_bytes, 0, strings, {}};
+    for (size_t i = 0; i < repeat; i++) {
+        if (before_each) before_each();
+        auto start = std::chrono::steady_clock::now();
+        phase.output_bytes = f();
+        phase.seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+    return phase;
+}
+
+// Sum of one byte per page, so every page of the mapping is faulted in
+uint64_t touch(const MappedFile& file) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < file.size(); i += 4096) {
+        sum += static_cast<uint8_t>(file.data()[i]);
+    }
+    return sum;
+}
+
+uint64_t write_all(const std::vector<DecodedRecords>& pages) {
+    OutputWriter writer{std::string(kNullDevice)};
+    uint64_t bytes = 0;
+    uint64_t id = 0;
+    for (const auto& records : pages) {
+        for (size_t i = 0; i < records.size(); i++) {
+            writer.write_record(id++, records[i]);
+            bytes += records[i].size() + 1;
+        }
+    }
+    writer.flush();
+    return bytes;
+}
+
+Result bench_file(const std::string& path, const BenchOptions& options) {
+    Result result;
+    result.name = path;
+    result.kind = "file";
+    result.bytes = std::filesystem::file_size(path);
+    std::function<void()> cold = options.cold ? std::function<void()>([&] { drop_cache(path); }) : nullptr;
+
+    MappedFile file(path);
+    if (!file) throw std::runtime_error("Error opening file: " + path);
+    kaitai::kstream ks(file.data(), file.size());
+    column_data_dictionary_t dictionary(&ks);
+
+    std::vector<column_data_dictionary_t::compressed_strings_t*> stores;
+    std::vector<column_data_dictionary_t::dictionary_page_t*> pages;
+    std::vector<size_t> page_begin;
+    std::vector<uint32_t> offsets;
+    const bool is_string = dictionary.dictionary_type() == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_STRING;
+    if (is_string) {
+        auto string_data = static_cast<column_data_dictionary_t::string_data_t*>(dictionary.data());
+        auto handles = string_data->dictionary_record_handles_vector_info()->vector_of_record_handle_structures();
+        result.strings = handles->size();
+        pages.assign(string_data->dictionary_pages()->begin(), string_data->dictionary_pages()->end());
+        offsets = group_offsets_by_page(*handles, pages.size(), page_begin);
+        for (auto page : pages) {
+            if (page->page_compressed()) stores.push_back(static_cast<column_data_dictionary_t::compressed_strings_t*>(page->string_store()));
+        }
+    } else {
+        result.strings = static_cast<column_data_dictionary_t::number_data_t*>(dictionary.data())->vector_of_vectors_info()->num_values();
+    }
+
+    const size_t repeat = options.repeat;
+    result.phases.push_back(run_phase("read", repeat, result.bytes, result.strings, [&] {
+        MappedFile mapped(path);
+        sink = touch(mapped);
+        return uint64_t(0);
+    }, cold));
+    result.phases.push_back(run_phase("parse", repeat, result.bytes, result.strings, [&] {
+        MappedFile mapped(path);
+        kaitai::kstream stream(mapped.data(), mapped.size());
+        column_data_dictionary_t parsed(&stream);
+        return uint64_t(0);
+    }, cold));
+
+    if (!is_string) {
+        auto vector_info = static_cast<column_data_dictionary_t::number_data_t*>(dictionary.data())->vector_of_vectors_info();
+        result.phases.push_back(run_phase("output", repeat, result.bytes, result.strings, [&] {
+            OutputWriter writer{std::string(kNullDevice)};
+            uint64_t bytes = 0;
+            for (uint64_t i = 0; i < vector_info->num_values(); i++) {
+                char* out = writer.begin_record(i, kMaxNumberSize);
+                size_t size = vector_info->is_int32() ? format_number(vector_info->values_int32()->at(i), out)
+                            : vector_info->is_int64() ? format_number(vector_info->values_int64()->at(i), out)
+                            : format_number(vector_info->values_float64()->at(i), out);
+                writer.end_record(size);
+                bytes += size + 1;
+            }
+            writer.flush();
+            return bytes;
+        }));
+        return result;
+    }
+
+    result.phases.push_back(run_phase("code_generation", repeat, result.bytes, result.strings, [&] {
+        uint64_t codes = 0;
+        for (auto store : stores) {
+            codes += generate_codes(decompress_encode_array(*store->encode_array())).size();
+        }
+        sink = codes;
+        return uint64_t(0);
+    }));
+    result.phases.push_back(run_phase("tree_build", repeat, result.bytes, result.strings, [&] {
+        for (auto store : stores) {
+            std::unique_ptr<HuffmanTree> tree(build_huffman_tree(decompress_encode_array(*store->encode_array())));
+            sink = tree->c;
+        }
+        return uint64_t(0);
+    }));
+    result.phases.push_back(run_phase("table_build", repeat, result.bytes, result.strings, [&] {
+        for (auto store : stores) {
+            HuffmanDecoder decoder(decompress_encode_array(*store->encode_array()), store->ui_decode_bits());
+            sink = decoder.table_bits();
+        }
+        return uint64_t(0);
+    }));
+
+    std::vector<DecodedRecords> decoded(pages.size());
+    auto decode = [&](const DecodeOptions& decode_options) {
+        uint64_t bytes = 0;
+        for (size_t p = 0; p < pages.size(); p++) {
+            RecordOffsets page_offsets{offsets.data() + page_begin[p], page_begin[p + 1] - page_begin[p]};
+            decode_page(pages[p], static_cast<uint32_t>(p), page_offsets, decode_options, decoded[p]);
+            bytes += decoded[p].bytes.size();
+        }
+        return bytes;
+    };
+    DecodeOptions reference;
+    reference.use_reference = true;
+    result.phases.push_back(run_phase("decode", repeat, result.bytes, result.strings, [&] { return decode(DecodeOptions()); }));
+    result.phases.push_back(run_phase("decode_reference", repeat, result.bytes, result.strings, [&] { return decode(reference); }));
+    result.phases.push_back(run_phase("output", repeat, result.bytes, result.strings, [&] { return write_all(decoded); }));
+    return result;
+}
+
+// Deterministic random values for synthetic dictionaries: ISO-8859-1 text
+// with a skewed character distribution, like real text, of uniformly
+// distributed length around a mean. The same seed gives the same values, so
+// they can be generated again to check a round trip instead of kept in memory.
+class SyntheticStrings {
+public:
+    SyntheticStrings(size_t mean_length, uint32_t seed)
+        : m_rng(seed), m_rank(0.08), m_length(1, 2 * mean_length - 1) {
+        m_alphabet = " etaoinshrdlcumwfgypbvkjxqzETAOINSHRDLCUMWFGYPBVKJXQZ0123456789-_.,/";
+        for (int c = 0xC0; c < 0x100; c++) {
+            m_alphabet += static_cast<char>(0xC0 | (c >> 6));
+            m_alphabet += static_cast<char>(0x80 | (c & 0x3F));
+        }
+    }
+
+    // UTF-8 value, valid until the next call
+    const std::string& next() {
+        m_value.clear();
+        for (size_t n = m_length(m_rng); n > 0; n--) {
+            size_t rank = std::min<size_t>(m_rank(m_rng), kSymbols - 1);
+            // Single-byte symbols first, then the two-byte UTF-8 forms of U+00C0..U+00FF
+            if (rank < kAsciiSymbols) {
+                m_value += m_alphabet[rank];
+            } else {
+                m_value.append(m_alphabet, kAsciiSymbols + 2 * (rank - kAsciiSymbols), 2);
+            }
+        }
+        return m_value;
+    }
+
+private:
+    static constexpr size_t kAsciiSymbols = 68;
+    static constexpr size_t kSymbols = kAsciiSymbols + 64;
+
+    std::mt19937 m_rng;
+    std::geometric_distribution<int> m_rank;
+    std::uniform_int_distribution<size_t> m_length;
+    std::string m_alphabet;
+    std::string m_value;
+};
+
+// Write a synthetic string dictionary, read it back to check that every value
+// survives the round trip and benchmark it like any other file
+Result bench_synthetic(const BenchOptions& options) {
+    const std::string path = options.synthetic_path.empty()
+        ? (std::filesystem::temp_directory_path() / ("dictionary_bench_" + std::to_string(options.seed) + ".dictionary")).string()
+        : options.synthetic_path;
+
+    WriterOptions writer_options;
+    writer_options.page_strings = options.synthetic_page_strings;
+    StringDictionaryWriter writer(path, writer_options);
+    SyntheticStrings generated(options.synthetic_length, options.seed);
+    for (uint64_t i = 0; i < options.synthetic_strings; i++) {
+        writer.add(generated.next());
+    }
+    writer.finish();
+
+    {
+        DictionaryReader reader(path);
+        SyntheticStrings expected(options.synthetic_length, options.seed);
+        reader.for_each([&](uint64_t id, std::string_view value) {
+            if (value != expected.next()) {
+                throw std::runtime_error("synthetic value " + std::to_string(id) + " does not decode to its input");
+            }
+        });
+    }
+
+    Result result = bench_file(path, options);
+    result.kind = "synthetic";
+    result.name = "synthetic-" + std::to_string(options.synthetic_strings) + "x" + std::to_string(options.synthetic_length);
+    if (options.synthetic_path.empty()) {
+        std::filesystem::remove(path);
+    }
+    return result;
+}
+
+void print_json(const std::vector<Result>& results, const BenchOptions& options, std::ostream& out) {
+    out << "{\n  \"version\": " << kJsonVersion << ",\n  \"repeat\": " << options.repeat << ",\n  \"mode\": \"" << (options.cold ? "cold" : "warm") << "\",\n  \"results\": [";
+    for (size_t r = 0; r < results.size(); r++) {
+        const Result& result = results[r];
+        out << (r ? "," : "") << "\n    {\"name\": " << json_string(result.name) << ", \"kind\": \"" << result.kind
+            << "\", \"bytes\": " << result.bytes << ", \"strings\": " << result.strings << ", \"phases\": {";
+        for (size_t p = 0; p < result.phases.size(); p++) {
+            const Phase& phase = result.phases[p];
+            std::vector<double> sorted = phase.seconds;
+            std::sort(sorted.begin(), sorted.end());
+            double best = sorted.front();
+            double median = sorted[sorted.size() / 2];
+            double mb = phase.input_bytes / (1024.0 * 1024.0);
+            out << (p ? "," : "") << "\n      " << json_string(phase.name) << ": {"
+                << "\"min_ms\": " << best * 1000 << ", \"median_ms\": " << median * 1000
+                << ", \"mb_per_s\": " << (best > 0 ? mb / best : 0)
+                << ", \"output_mb_per_s\": " << (best > 0 ? phase.output_bytes / (1024.0 * 1024.0) / best : 0)
+                << ", \"strings_per_s\": " << (best > 0 ? phase.strings / best : 0)
+                << ", \"ns_per_string\": " << (phase.strings ? best * 1e9 / phase.strings : 0) << "}";
+        }
+        out << "\n    }}";
+    }
+    out << "\n  ]\n}\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--repeat" && i + 1 < argc) {
+            options.repeat = std::max<size_t>(1, std::stoul(argv[++i]));
+        } else if (arg == "--cold") {
+            options.cold = true;
+        } else if (arg == "--synthetic" && i + 1 < argc) {
+            options.synthetic_strings = std::stoull(argv[++i]);
+        } else if (arg == "--synthetic-length" && i + 1 < argc) {
+            options.synthetic_length = std::max<size_t>(1, std::stoul(argv[++i]));
+        } else if (arg == "--synthetic-page-strings" && i + 1 < argc) {
+            options.synthetic_page_strings = std::max<uint64_t>(1, std::stoull(argv[++i]));
+        } else if (arg == "--synthetic-out" && i + 1 < argc) {
+            options.synthetic_path = argv[++i];
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg.rfind("--", 0) != 0) {
+            inputs.push_back(arg);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--repeat N] [--cold] [--synthetic N] [--synthetic-length L] [--synthetic-page-strings N] [--synthetic-out PATH] [--seed S] [paths...]" << std::endl;
+            return 1;
+        }
+    }
+    if (inputs.empty()) {
+        inputs.push_back("data");
+    }
+
+    std::vector<Result> results;
+    try {
+        for (const std::string& path : expand_inputs(inputs)) {
+            results.push_back(bench_file(path, options));
+        }
+        if (options.synthetic_strings) {
+            results.push_back(bench_synthetic(options));
+        }
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    print_json(results, options, std::cout);
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "dictionary_c_api.h"
+
+#include <stdexcept>
+#include <string>
+
+#include "dictionary_reader.h"
+
+struct vdict_reader {
+    explicit vdict_reader(const char* path) : reader(path) {}
+
+    DictionaryReader reader;
+    std::string value;      // backs the pointer returned by vdict_get()
+    DecodedRecords records; // backs the pointers returned by vdict_decode_page()
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+// Run f, turning exceptions into a status and the thread's last error
+template <typename F>
+int guarded(F&& f) {
+    try {
+        return f();
+    } catch (const std::out_of_range& e) {
+        last_error = e.what();
+        return VDICT_OUT_OF_RANGE;
+    } catch (const std::exception& e) {
+        last_error = e.what();
+        return VDICT_ERROR;
+    } catch (...) {
+        last_error = "unknown error";
+        return VDICT_ERROR;
+    }
+}
+
+// Thrown out of a visitor that asked to stop, caught in vdict_for_each()
+struct StopVisiting {};
+
+} // namespace
+
+extern "C" {
+
+int vdict_open(const char* path, vdict_reader** reader) {
+    *reader = nullptr;
+    return guarded([&] {
+        *reader = new vdict_reader(path);
+        return VDICT_OK;
+    });
+}
+
+void vdict_close(vdict_reader* reader) {
+    delete reader;
+}
+
+const char* vdict_last_error(void) {
+    return last_error.c_str();
+}
+
+int vdict_type(const vdict_reader* reader) {
+    return reader->reader.dictionary_type();
+}
+
+uint64_t vdict_size(const vdict_reader* reader) {
+    return reader->reader.size();
+}
+
+uint32_t vdict_page_count(const vdict_reader* reader) {
+    return static_cast<uint32_t>(reader->reader.pages().size());
+}
+
+int vdict_page_info_get(const vdict_reader* reader, uint32_t page_id, vdict_page_info* info) {
+    const auto& pages = reader->reader.pages();
+    if (page_id >= pages.size()) {
+        last_error = "page " + std::to_string(page_id) + " out of range";
+        return VDICT_OUT_OF_RANGE;
+    }
+    const DictionaryReader::PageInfo& page = pages[page_id];
+    *info = vdict_page_info{page.page_id, page.compressed ? 1 : 0, page.first_id, page.value_count, page.store_bytes};
+    return VDICT_OK;
+}
+
+int vdict_get(vdict_reader* reader, uint64_t id, const char** value, size_t* length) {
+    return guarded([&] {
+        reader->value = reader->reader.get(id);
+        *value = reader->value.data();
+        *length = reader->value.size();
+        return VDICT_OK;
+    });
+}
+
+int vdict_for_each(vdict_reader* reader, vdict_visitor visitor, void* context) {
+    return guarded([&] {
+        try {
+            reader->reader.for_each([&](uint64_t id, std::string_view value) {
+                if (visitor(context, id, value.data(), value.size())) throw StopVisiting();
+            });
+        } catch (const StopVisiting&) {
+            return VDICT_STOPPED;
+        }
+        return VDICT_OK;
+    });
+}
+
+int vdict_decode_page(vdict_reader* reader, uint32_t page_id, const char** data, const uint32_t** ends,
+                      size_t* count, uint32_t* separator) {
+    return guarded([&] {
+        reader->reader.decode_page(page_id, reader->records);
+        *data = reader->records.bytes.data();
+        *ends = reader->records.ends.data();
+        *count = reader->records.size();
+        *separator = reader->records.separator;
+        return VDICT_OK;
+    });
+}
+
+}
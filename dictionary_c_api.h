@@ -0,0 +1,71 @@
+#ifndef DICTIONARY_C_API_H_
+#define DICTIONARY_C_API_H_
+
+/* C interface to DictionaryReader for embedding from other languages.
+ *
+ * Functions return VDICT_OK or a negative status. The message of the last
+ * failure on the calling thread is available from vdict_last_error(). Values
+ * are UTF-8 and not NUL-terminated; the pointers handed out stay valid until
+ * the next call on the same reader. A reader must not be used from two
+ * threads at once. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct vdict_reader vdict_reader;
+
+enum {
+    VDICT_OK = 0,
+    VDICT_ERROR = -1,
+    VDICT_OUT_OF_RANGE = -2,
+    VDICT_STOPPED = -3 /* a visitor returned non-zero */
+};
+
+/* Same values as column_data_dictionary_t::dictionary_types_t */
+enum {
+    VDICT_TYPE_LONG = 0,
+    VDICT_TYPE_REAL = 1,
+    VDICT_TYPE_STRING = 2
+};
+
+typedef struct vdict_page_info {
+    uint32_t page_id;
+    int compressed;
+    uint64_t first_id;
+    uint64_t value_count;
+    uint64_t store_bytes;
+} vdict_page_info;
+
+/* Return non-zero to stop the iteration */
+typedef int (*vdict_visitor)(void* context, uint64_t id, const char* value, size_t length);
+
+int vdict_open(const char* path, vdict_reader** reader);
+void vdict_close(vdict_reader* reader);
+const char* vdict_last_error(void);
+
+int vdict_type(const vdict_reader* reader);
+uint64_t vdict_size(const vdict_reader* reader);
+uint32_t vdict_page_count(const vdict_reader* reader);
+int vdict_page_info_get(const vdict_reader* reader, uint32_t page_id, vdict_page_info* info);
+
+/* One value by data ID */
+int vdict_get(vdict_reader* reader, uint64_t id, const char** value, size_t* length);
+
+/* Every value in data ID order */
+int vdict_for_each(vdict_reader* reader, vdict_visitor visitor, void* context);
+
+/* Bulk decode of one page of a string dictionary: `count` values laid out in
+ * `data`, value i ending at ends[i] and the next one starting `separator`
+ * bytes later. */
+int vdict_decode_page(vdict_reader* reader, uint32_t page_id, const char** data, const uint32_t** ends,
+                      size_t* count, uint32_t* separator);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DICTIONARY_C_API_H_ */
@@ -0,0 +1,356 @@
+#include "dictionary_dump.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <type_traits>
+
+#include "kaitai/kaitaistream.h"
+#include "arrow_writer.h"
+#include "column_data_dictionary.h"
+#include "mapped_file.h"
+#include "stats.h"
+#include "thread_pool.h"
+#include "value_cache.h"
+
+namespace {
+
+void write_records(OutputWriter& writer, uint64_t first_id, const RecordsView& records) {
+    for (size_t i = 0; i < records.size(); i++) {
+        writer.write_record(first_id + i, records[i]);
+    }
+}
+
+// String values collected for --format arrow, in Arrow's offsets + data layout
+struct StringColumn {
+    std::string data;
+    std::vector<int64_t> offsets{0};
+
+    void append(const RecordsView& records) {
+        if (records.separator == 0) {
+            // Already back to back: one copy for the whole run
+            const int64_t base = static_cast<int64_t>(data.size());
+            data.append(records.bytes, records.count ? records.ends[records.count - 1] : 0);
+            for (size_t i = 0; i < records.count; i++) {
+                offsets.push_back(base + records.ends[i]);
+            }
+            return;
+        }
+        for (size_t i = 0; i < records.size(); i++) {
+            data += records[i];
+            offsets.push_back(static_cast<int64_t>(data.size()));
+        }
+    }
+};
+
+// Code points and UTF-8 bytes of a run of records, for --stats
+void count_characters(const RecordsView& records, Stats::PageStats& page) {
+    for (size_t i = 0; i < records.size(); i++) {
+        std::string_view value = records[i];
+        page.decoded_bytes += value.size();
+        for (char c : value) {
+            page.characters += (static_cast<uint8_t>(c) & 0xC0) != 0x80;
+        }
+    }
+    page.strings += records.size();
+}
+
+// Write the values of a mapped sidecar; see ValueCache
+void write_cached(const ValueCache& cache, const std::string& column_name, const DumpOptions& run, OutputWriter& writer) {
+    Stats::Timer timer(Stats::kOutput);
+    const uint64_t count = cache.size();
+    if (cache.kind() == ValueCache::Kind::kStrings) {
+        if (run.arrow) {
+            std::vector<int64_t> offsets(cache.offsets(), cache.offsets() + count + 1);
+            // The copy is checked as it is made, as operator[] checks each value
+            bool ordered = offsets[0] == 0 && static_cast<uint64_t>(offsets[count]) == cache.data().size();
+            for (uint64_t i = 0; ordered && i < count; i++) {
+                ordered = offsets[i] <= offsets[i + 1];
+            }
+            if (!ordered) {
+                throw std::runtime_error("Damaged cache file: value offsets out of range");
+            }
+            ArrowWriter(writer).write_strings(column_name, cache.data(), offsets);
+            return;
+        }
+        for (uint64_t i = 0; i < count; i++) {
+            writer.write_record(i, cache[i]);
+        }
+        return;
+    }
+
+    auto write_values = [&](const auto* vals) {
+        using T = std::remove_const_t<std::remove_pointer_t<decltype(vals)>>;
+        if (run.arrow) {
+            ArrowWriter arrow_writer(writer);
+            if constexpr (std::is_same_v<T, int32_t>) {
+                arrow_writer.write_int32(column_name, vals, count);
+            } else if constexpr (std::is_same_v<T, int64_t>) {
+                arrow_writer.write_int64(column_name, vals, count);
+            } else {
+                arrow_writer.write_float64(column_name, vals, count);
+            }
+            return;
+        }
+        for (uint64_t i = 0; i < count; i++) {
+            char* out = writer.begin_record(i, kMaxNumberSize);
+            writer.end_record(format_number(vals[i], out));
+        }
+    };
+    if (cache.kind() == ValueCache::Kind::kInt32) {
+        write_values(cache.values<int32_t>());
+    } else if (cache.kind() == ValueCache::Kind::kInt64) {
+        write_values(cache.values<int64_t>());
+    } else {
+        write_values(cache.values<double>());
+    }
+}
+
+} // namespace
+
+uint64_t dump_dictionary(const std::string& filename, const DumpOptions& run, OutputWriter& writer) {
+    const DecodeOptions& options = run.decode;
+    const std::string column_name = std::filesystem::path(filename).stem().string();
+
+    // A valid sidecar replaces parsing and decoding with one mapping
+    if (run.cache) {
+        const std::string sidecar = ValueCache::sidecar_path(filename, run.cache_dir);
+        ValueCache cache;
+        Stats::Timer open_timer(Stats::kOpen);
+        const bool hit = cache.open(filename, sidecar);
+        open_timer.stop();
+        Stats::count_value_cache(hit);
+        bool cached = hit;
+        if (!hit) {
+            // A sidecar that cannot be written or read back only loses the
+            // speed-up; the values are then decoded as without --cache
+            try {
+                if (!run.cache_dir.empty()) {
+                    std::filesystem::create_directories(run.cache_dir);
+                }
+                ValueCache::build(filename, sidecar);
+                cached = cache.open(filename, sidecar);
+                if (!cached) {
+                    std::cerr << "Warning: cannot read cache file " << sidecar << std::endl;
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Warning: cannot cache " << filename << ": " << e.what() << std::endl;
+            }
+        }
+        if (cached) {
+            write_cached(cache, column_name, run, writer);
+            {
+                Stats::Timer timer(Stats::kOutput);
+                writer.flush();
+            }
+            Stats::add_file(std::filesystem::file_size(filename), cache.size());
+            return cache.size();
+        }
+    }
+
+    // Open the file and check if it opened successfully. By default the file is
+    // mapped and page buffers are parsed as views into the mapping.
+    Stats::Timer open_timer(Stats::kOpen);
+    std::ifstream is;
+    MappedFile mapped;
+    if (run.use_stream) {
+        is.open(filename, std::ifstream::binary);
+    } else {
+        mapped.open(filename);
+    }
+    if (run.use_stream ? !is : !mapped) {
+        throw std::runtime_error("Error opening file: " + filename);
+    }
+    kaitai::kstream ks = run.use_stream ? kaitai::kstream(&is) : kaitai::kstream(mapped.data(), mapped.size());
+    open_timer.stop();
+
+    Stats::Timer parse_timer(Stats::kParse);
+    column_data_dictionary_t dictionary(&ks, nullptr, nullptr,
+        run.lazy ? column_data_dictionary_t::READ_MODE_LAZY : column_data_dictionary_t::READ_MODE_EAGER);
+    parse_timer.stop();
+
+    uint64_t values = 0;
+    // Checking dictionary type and processing accordingly
+    if (dictionary.dictionary_type() == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_STRING) {
+        auto stringData = static_cast<column_data_dictionary_t::string_data_t*>(dictionary.data());
+        auto pages = stringData->dictionary_pages();
+        auto record_handles = stringData->dictionary_record_handles_vector_info()->vector_of_record_handle_structures();
+        std::vector<size_t> page_begin;
+        std::vector<uint32_t> grouped_offsets = group_offsets_by_page(*record_handles, pages->size(), page_begin);
+        auto page_offsets = [&](uint32_t page_id) {
+            return RecordOffsets{grouped_offsets.data() + page_begin[page_id], page_begin[page_id + 1] - page_begin[page_id]};
+        };
+
+        std::vector<Stats::PageStats> page_stats(Stats::enabled() ? pages->size() : 0);
+        StringColumn column;
+        auto emit = [&](uint32_t page_id, uint64_t first_id, const RecordsView& records) {
+            if (!page_stats.empty()) count_characters(records, page_stats[page_id]);
+            Stats::Timer timer(Stats::kOutput);
+            if (run.arrow) {
+                column.append(records);
+            } else {
+                write_records(writer, first_id, records);
+            }
+            values += records.size();
+        };
+
+        if (run.threads == 1) {
+            DecodedRecords records;
+            for (uint32_t page_id = 0; page_id < pages->size(); page_id++) {
+                decode_page(pages->at(page_id), page_id, page_offsets(page_id), options, records);
+                emit(page_id, pages->at(page_id)->page_start_index(), records.view());
+            }
+        } else {
+            // Pages are independent: decode them on the pool, which starts tasks
+            // in submission order, largest page first so a huge page starts
+            // early, and write the results back in page order.
+            // Compressed pages are further split into contiguous runs of records,
+            // which the record handles delimit, so one dominant page still
+            // spreads over every worker. The runs of a page share one output
+            // buffer: each run's slot starts at the prefix sum of the decoded
+            // size bounds of the runs before it, so a run decodes in place and
+            // is written out from there.
+            struct PageTasks {
+                std::future<DecodedRecords> uncompressed;
+                std::unique_ptr<CompressedPage> compressed;
+                std::string bytes;               // the slots of every run
+                std::vector<uint32_t> ends;      // per record, from the start of its run's slot
+                std::vector<size_t> run_first;   // first record of each run, then the record count
+                std::vector<size_t> slot_begin;  // start of each run's slot in bytes
+                std::vector<std::future<size_t>> runs; // bytes decoded by each run
+            };
+            // Declared before the pool, which drains its queue on destruction,
+            // so a chunk that throws leaves the other chunks their pages
+            std::vector<PageTasks> tasks(pages->size());
+            ThreadPool pool(run.threads);
+            std::vector<uint32_t> order(pages->size());
+            for (uint32_t page_id = 0; page_id < pages->size(); page_id++) {
+                order[page_id] = page_id;
+                pages->at(page_id)->string_store(); // lazy stores are loaded here, not on the workers
+            }
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                return pages->at(a)->len_string_store_buffer() > pages->at(b)->len_string_store_buffer();
+            });
+
+            for (uint32_t page_id : order) {
+                auto page = pages->at(page_id);
+                const RecordOffsets offsets = page_offsets(page_id);
+                PageTasks& task = tasks[page_id];
+                if (!page->page_compressed()) {
+                    task.uncompressed = pool.submit([&, page, page_id, offsets]() {
+                        DecodedRecords records;
+                        decode_page(page, page_id, offsets, options, records);
+                        return records;
+                    });
+                    continue;
+                }
+                task.compressed.reset(new CompressedPage(static_cast<column_data_dictionary_t::compressed_strings_t*>(page->string_store()), options));
+                const size_t records_per_run = std::max(run.min_records_per_chunk, (offsets.size() + 4 * pool.size() - 1) / (4 * pool.size()));
+                size_t slot = 0;
+                for (size_t first = 0; first < offsets.size(); first += records_per_run) {
+                    const size_t last = std::min(first + records_per_run, offsets.size());
+                    task.run_first.push_back(first);
+                    task.slot_begin.push_back(slot);
+                    slot += decoded_capacity(*task.compressed, page_id, offsets, first, last);
+                }
+                task.run_first.push_back(offsets.size());
+                task.bytes.resize(slot);
+                task.ends.resize(offsets.size());
+                for (size_t r = 0; r + 1 < task.run_first.size(); r++) {
+                    task.runs.push_back(pool.submit([&, page_id, offsets, r]() {
+                        PageTasks& task = tasks[page_id];
+                        const size_t first = task.run_first[r];
+                        return decode_records(*task.compressed, page_id, offsets, first, task.run_first[r + 1], options,
+                                              &task.bytes[task.slot_begin[r]], &task.ends[first]);
+                    }));
+                }
+            }
+
+            // Runs are framed straight from their slots into the writer's
+            // buffer (or the Arrow column), in page order
+            for (uint32_t page_id = 0; page_id < pages->size(); page_id++) {
+                PageTasks& task = tasks[page_id];
+                uint64_t id = pages->at(page_id)->page_start_index();
+                if (task.uncompressed.valid()) {
+                    DecodedRecords records = task.uncompressed.get();
+                    emit(page_id, id, records.view());
+                    continue;
+                }
+                for (size_t r = 0; r < task.runs.size(); r++) {
+                    task.runs[r].get();
+                    const size_t first = task.run_first[r];
+                    const size_t count = task.run_first[r + 1] - first;
+                    emit(page_id, id, RecordsView{&task.bytes[task.slot_begin[r]], &task.ends[first], count, 0});
+                    id += count;
+                }
+            }
+        }
+        if (run.arrow) {
+            Stats::Timer timer(Stats::kOutput);
+            ArrowWriter(writer).write_strings(column_name, column.data, column.offsets);
+        }
+
+        for (size_t page_id = 0; page_id < page_stats.size(); page_id++) {
+            auto page = pages->at(page_id);
+            Stats::PageStats& stats = page_stats[page_id];
+            stats.file = filename;
+            stats.page_id = static_cast<uint32_t>(page_id);
+            stats.compressed = page->page_compressed() != 0;
+            if (stats.compressed) {
+                auto store = static_cast<column_data_dictionary_t::compressed_strings_t*>(page->string_store());
+                stats.store_bytes = store->len_compressed_string_buffer();
+                stats.bits = store->store_total_bits();
+                for (uint8_t packed : *store->encode_array()) {
+                    for (uint32_t length : {uint32_t(packed & 0x0F), uint32_t(packed >> 4)}) {
+                        stats.symbols += length != 0;
+                        stats.max_code_length = std::max(stats.max_code_length, length);
+                    }
+                }
+            } else {
+                stats.store_bytes = static_cast<column_data_dictionary_t::uncompressed_strings_t*>(page->string_store())->used_character_bytes().size();
+            }
+            Stats::add_page(stats);
+        }
+
+    } else if (dictionary.dictionary_type() == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_LONG ||
+                 dictionary.dictionary_type() == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_REAL)
+        {
+            // Handling numeric data, printed in its stored type so int64 keys stay exact
+            auto numberData = static_cast<column_data_dictionary_t::number_data_t *>(dictionary.data());
+            auto vector_info = numberData->vector_of_vectors_info();
+            values = vector_info->num_values();
+            Stats::Timer timer(Stats::kOutput);
+            // Formatted straight into the writer's buffer
+            auto write_values = [&writer](const auto& vals) {
+                for (size_t i = 0; i < vals.size(); i++) {
+                    char* out = writer.begin_record(i, kMaxNumberSize);
+                    writer.end_record(format_number(vals[i], out));
+                }
+            };
+            if (run.arrow) {
+                ArrowWriter arrow_writer(writer);
+                if (vector_info->is_int32()) {
+                    arrow_writer.write_int32(column_name, vector_info->values_int32()->data(), vector_info->values_int32()->size());
+                } else if (vector_info->is_int64()) {
+                    arrow_writer.write_int64(column_name, vector_info->values_int64()->data(), vector_info->values_int64()->size());
+                } else {
+                    arrow_writer.write_float64(column_name, vector_info->values_float64()->data(), vector_info->values_float64()->size());
+                }
+            } else if (vector_info->is_int32()) {
+                write_values(*vector_info->values_int32());
+            } else if (vector_info->is_int64()) {
+                write_values(*vector_info->values_int64());
+            } else {
+                write_values(*vector_info->values_float64());
+            }
+        }
+    {
+        Stats::Timer timer(Stats::kOutput);
+        writer.flush();
+    }
+    Stats::add_file(run.use_stream ? std::filesystem::file_size(filename) : mapped.size(), values);
+    return values;
+}
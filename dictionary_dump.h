@@ -0,0 +1,26 @@
+#ifndef DICTIONARY_DUMP_H_
+#define DICTIONARY_DUMP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "output_writer.h"
+#include "page_decoder.h"
+
+struct DumpOptions {
+    DecodeOptions decode;
+    size_t threads = 1;         // decode pages on a pool of this many workers, 0 = all cores
+    size_t min_records_per_chunk = 4096; // smallest run of records decoded as one task
+    bool use_stream = false;    // read through std::ifstream instead of mapping the file
+    bool lazy = false;          // parse page headers only, read stores as they are decoded
+    bool arrow = false;         // write an Arrow IPC file instead of framed values
+    bool cache = false;         // serve values from a decoded sidecar, building it when missing or stale
+    std::string cache_dir;      // directory of the sidecars, empty for next to each dictionary
+};
+
+// Decode every value of a dictionary file to writer, in data ID order, and
+// flush it. Returns the number of values written; throws on errors.
+uint64_t dump_dictionary(const std::string& filename, const DumpOptions& options, OutputWriter& writer);
+
+#endif  // DICTIONARY_DUMP_H_
@@ -0,0 +1,314 @@
+#include "dictionary_index.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+const char kMagic[4] = {'V', 'D', 'I', 'X'};
+const uint32_t kVersion = 2;
+
+uint64_t hash_bytes(std::string_view bytes) {
+    uint64_t hash = 14695981039346656037ull;
+    for (unsigned char c : bytes) {
+        hash = (hash ^ c) * 1099511628211ull;
+    }
+    return hash;
+}
+
+template <typename T>
+void put_le(std::string& out, T value) {
+    uint64_t bits;
+    if constexpr (std::is_floating_point_v<T>) {
+        std::memcpy(&bits, &value, sizeof(bits));
+    } else {
+        bits = static_cast<uint64_t>(value);
+    }
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out.push_back(static_cast<char>(bits >> (8 * i)));
+    }
+}
+
+// Bounds-checked little-endian reader over a loaded index file
+class IndexCursor {
+public:
+    IndexCursor(const std::string& bytes, const std::string& path) : m_bytes(bytes), m_path(path) {}
+
+    bool at_end() const { return m_pos == m_bytes.size(); }
+
+    std::string_view take(uint64_t size) {
+        if (size > m_bytes.size() - m_pos) {
+            throw std::runtime_error(m_path + " is truncated");
+        }
+        std::string_view bytes(m_bytes.data() + m_pos, size);
+        m_pos += size;
+        return bytes;
+    }
+
+    template <typename T>
+    T get() {
+        std::string_view bytes = take(sizeof(T));
+        uint64_t bits = 0;
+        for (size_t i = 0; i < sizeof(T); i++) {
+            bits |= static_cast<uint64_t>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+        }
+        T value;
+        if constexpr (std::is_floating_point_v<T>) {
+            std::memcpy(&value, &bits, sizeof(value));
+        } else {
+            value = static_cast<T>(bits);
+        }
+        return value;
+    }
+
+    // `count` elements, checked against the bytes left before allocating
+    template <typename T>
+    std::vector<T> get_vector(uint64_t count) {
+        if (count > (m_bytes.size() - m_pos) / sizeof(T)) {
+            throw std::runtime_error(m_path + " is truncated");
+        }
+        std::vector<T> values(count);
+        for (T& value : values) value = get<T>();
+        return values;
+    }
+
+private:
+    const std::string& m_bytes;
+    const std::string& m_path;
+    size_t m_pos = 0;
+};
+
+// Values sorted with their data IDs; stable, so equal values keep the lower ID first
+template <typename T, typename Allocator>
+void sort_values(const std::vector<T, Allocator>& values, std::vector<T>& keys, std::vector<uint32_t>& ids) {
+    std::vector<uint32_t> order;
+    order.reserve(values.size());
+    for (uint32_t id = 0; id < values.size(); id++) {
+        if (values[id] == values[id]) order.push_back(id);  // skips NaN
+    }
+    std::stable_sort(order.begin(), order.end(), [&values](uint32_t a, uint32_t b) { return values[a] < values[b]; });
+    keys.resize(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        keys[i] = values[order[i]];
+    }
+    ids.swap(order);
+}
+
+template <typename T>
+std::optional<uint64_t> find_sorted(const std::vector<T>& keys, const std::vector<uint32_t>& ids, T value) {
+    auto it = std::lower_bound(keys.begin(), keys.end(), value);
+    if (it == keys.end() || *it != value) return std::nullopt;
+    return ids[it - keys.begin()];
+}
+
+} // namespace
+
+DictionaryIndex DictionaryIndex::build(const std::string& dictionary_path) {
+    DictionaryIndex index;
+    index.m_source = source_key(dictionary_path);
+    DictionaryReader dictionary(dictionary_path);
+    if (dictionary.size() >= UINT32_MAX) {
+        throw std::runtime_error("dictionary of " + std::to_string(dictionary.size()) + " values is too large to index");
+    }
+    index.m_size = dictionary.size();
+
+    if (dictionary.is_string()) {
+        index.m_kind = Kind::kStrings;
+        index.m_ends.reserve(index.m_size);
+        size_t capacity = 16;
+        while (capacity < 2 * index.m_size) capacity *= 2;
+        index.m_slots.assign(capacity, 0);
+        dictionary.for_each([&index](uint64_t id, std::string_view value) {
+            index.m_bytes.append(value.data(), value.size());
+            if (index.m_bytes.size() > UINT32_MAX) {
+                throw std::runtime_error("dictionary of more than 4 GiB of strings is too large to index");
+            }
+            index.m_ends.push_back(static_cast<uint32_t>(index.m_bytes.size()));
+            index.insert_string(static_cast<uint32_t>(id));
+        });
+        return index;
+    }
+
+    auto number_data = static_cast<column_data_dictionary_t::number_data_t*>(dictionary.dictionary().data());
+    auto vector_info = number_data->vector_of_vectors_info();
+    if (vector_info->is_int32()) {
+        index.m_kind = Kind::kIntegers;
+        const auto& values = *vector_info->values_int32();
+        sort_values(std::vector<int64_t>(values.begin(), values.end()), index.m_integers, index.m_ids);
+    } else if (vector_info->is_int64()) {
+        index.m_kind = Kind::kIntegers;
+        sort_values(*vector_info->values_int64(), index.m_integers, index.m_ids);
+    } else {
+        index.m_kind = Kind::kReals;
+        sort_values(*vector_info->values_float64(), index.m_reals, index.m_ids);
+    }
+    return index;
+}
+
+std::string_view DictionaryIndex::string_value(uint32_t id) const {
+    const uint32_t begin = id ? m_ends[id - 1] : 0;
+    return std::string_view(m_bytes.data() + begin, m_ends[id] - begin);
+}
+
+void DictionaryIndex::insert_string(uint32_t id) {
+    std::string_view value = string_value(id);
+    const size_t mask = m_slots.size() - 1;
+    for (size_t slot = hash_bytes(value) & mask;; slot = (slot + 1) & mask) {
+        if (m_slots[slot] == 0) {
+            m_slots[slot] = id + 1;
+            return;
+        }
+        if (string_value(m_slots[slot] - 1) == value) return;  // keep the lower ID
+    }
+}
+
+std::optional<uint64_t> DictionaryIndex::find(std::string_view value) const {
+    switch (m_kind) {
+    case Kind::kStrings: {
+        if (m_slots.empty()) return std::nullopt;
+        const size_t mask = m_slots.size() - 1;
+        for (size_t slot = hash_bytes(value) & mask; m_slots[slot] != 0; slot = (slot + 1) & mask) {
+            if (string_value(m_slots[slot] - 1) == value) return m_slots[slot] - 1;
+        }
+        return std::nullopt;
+    }
+    case Kind::kIntegers: {
+        int64_t number;
+        auto result = std::from_chars(value.data(), value.data() + value.size(), number);
+        if (result.ec == std::errc() && result.ptr == value.data() + value.size()) return find_integer(number);
+        break;
+    }
+    case Kind::kReals: {
+        double number;
+        auto result = std::from_chars(value.data(), value.data() + value.size(), number);
+        if (result.ec == std::errc() && result.ptr == value.data() + value.size()) return find_real(number);
+        break;
+    }
+    }
+    return std::nullopt;
+}
+
+std::optional<uint64_t> DictionaryIndex::find_integer(int64_t value) const {
+    if (m_kind == Kind::kIntegers) return find_sorted(m_integers, m_ids, value);
+    // Only integers a double holds exactly can be in a real dictionary
+    const double real = static_cast<double>(value);
+    if (m_kind == Kind::kReals && real < 9223372036854775808.0 && static_cast<int64_t>(real) == value) {
+        return find_real(real);
+    }
+    return std::nullopt;
+}
+
+std::optional<uint64_t> DictionaryIndex::find_real(double value) const {
+    if (m_kind == Kind::kReals) return find_sorted(m_reals, m_ids, value);
+    // Integral and inside the int64_t range (2^63 is exact as a double)
+    if (m_kind == Kind::kIntegers && std::trunc(value) == value && value >= -9223372036854775808.0 &&
+        value < 9223372036854775808.0) {
+        return find_integer(static_cast<int64_t>(value));
+    }
+    return std::nullopt;
+}
+
+void DictionaryIndex::save(const std::string& path) const {
+    std::string bytes(kMagic, sizeof(kMagic));
+    put_le<uint32_t>(bytes, kVersion);
+    put_le<uint32_t>(bytes, static_cast<uint32_t>(m_kind));
+    put_le<uint64_t>(bytes, m_source.size);
+    put_le<int64_t>(bytes, m_source.mtime);
+    put_le<uint64_t>(bytes, m_source.hash);
+    put_le<uint64_t>(bytes, m_size);
+    if (m_kind == Kind::kStrings) {
+        put_le<uint64_t>(bytes, m_bytes.size());
+        bytes += m_bytes;
+        for (uint32_t end : m_ends) put_le(bytes, end);
+        put_le<uint64_t>(bytes, m_slots.size());
+        for (uint32_t slot : m_slots) put_le(bytes, slot);
+    } else {
+        put_le<uint64_t>(bytes, m_ids.size());
+        if (m_kind == Kind::kIntegers) {
+            for (int64_t value : m_integers) put_le(bytes, value);
+        } else {
+            for (double value : m_reals) put_le(bytes, value);
+        }
+        for (uint32_t id : m_ids) put_le(bytes, id);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Error opening file: " + path);
+    }
+    out.write(bytes.data(), bytes.size());
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Error writing file: " + path);
+    }
+}
+
+DictionaryIndex DictionaryIndex::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Error opening file: " + path);
+    }
+    const std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    IndexCursor cursor(bytes, path);
+    if (bytes.size() < sizeof(kMagic) || std::memcmp(bytes.data(), kMagic, sizeof(kMagic)) != 0) {
+        throw std::runtime_error(path + " is not a dictionary index");
+    }
+    cursor.take(sizeof(kMagic));
+    const uint32_t version = cursor.get<uint32_t>();
+    if (version != kVersion) {
+        throw std::runtime_error(path + " is a version " + std::to_string(version) + " dictionary index, expected " +
+                                 std::to_string(kVersion));
+    }
+
+    DictionaryIndex index;
+    const uint32_t kind = cursor.get<uint32_t>();
+    index.m_source.size = cursor.get<uint64_t>();
+    index.m_source.mtime = cursor.get<int64_t>();
+    index.m_source.hash = cursor.get<uint64_t>();
+    index.m_size = cursor.get<uint64_t>();
+    const std::runtime_error corrupt(path + " is corrupt");
+    if (kind == static_cast<uint32_t>(Kind::kStrings)) {
+        index.m_kind = Kind::kStrings;
+        index.m_bytes = std::string(cursor.take(cursor.get<uint64_t>()));
+        index.m_ends = cursor.get_vector<uint32_t>(index.m_size);
+        index.m_slots = cursor.get_vector<uint32_t>(cursor.get<uint64_t>());
+        // Checked once here so find() can trust every offset and slot
+        if (!std::is_sorted(index.m_ends.begin(), index.m_ends.end()) ||
+            (!index.m_ends.empty() && index.m_ends.back() > index.m_bytes.size())) {
+            throw corrupt;
+        }
+        const size_t slots = index.m_slots.size();
+        const uint64_t used = std::count_if(index.m_slots.begin(), index.m_slots.end(), [](uint32_t slot) { return slot != 0; });
+        if (slots == 0 || (slots & (slots - 1)) != 0 || used == slots ||
+            std::any_of(index.m_slots.begin(), index.m_slots.end(), [&index](uint32_t slot) { return slot > index.m_size; })) {
+            throw corrupt;
+        }
+    } else if (kind == static_cast<uint32_t>(Kind::kIntegers) || kind == static_cast<uint32_t>(Kind::kReals)) {
+        index.m_kind = static_cast<Kind>(kind);
+        // NaN reals are left out, so there can be fewer keys than values
+        const uint64_t keys = cursor.get<uint64_t>();
+        if (keys > index.m_size) throw corrupt;
+        bool sorted;
+        if (index.m_kind == Kind::kIntegers) {
+            index.m_integers = cursor.get_vector<int64_t>(keys);
+            sorted = std::is_sorted(index.m_integers.begin(), index.m_integers.end());
+        } else {
+            index.m_reals = cursor.get_vector<double>(keys);
+            sorted = std::is_sorted(index.m_reals.begin(), index.m_reals.end());
+        }
+        index.m_ids = cursor.get_vector<uint32_t>(keys);
+        if (!sorted || std::any_of(index.m_ids.begin(), index.m_ids.end(), [&index](uint32_t id) { return id >= index.m_size; })) {
+            throw corrupt;
+        }
+    } else {
+        throw corrupt;
+    }
+    if (!cursor.at_end()) throw corrupt;
+    return index;
+}
@@ -0,0 +1,86 @@
+#ifndef DICTIONARY_INDEX_H_
+#define DICTIONARY_INDEX_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "dictionary_reader.h"
+#include "source_key.h"
+
+// Reverse lookup of a dictionary: value -> data ID.
+//
+// String dictionaries are indexed by an open-addressing hash table (linear
+// probing, FNV-1a, at most half full) of 32-bit data IDs over a copy of the
+// decoded UTF-8 bytes with 32-bit end offsets, so lookups need no dictionary.
+// Numeric dictionaries are indexed by their values sorted next to their IDs
+// and searched by bisection. Values are matched exactly, and if a value occurs
+// twice the lower data ID is found. NaN reals are not indexed.
+//
+// An index is built with a single decoding pass over the dictionary and can
+// be saved and loaded again without the dictionary. It records the SourceKey
+// of the dictionary it was built from, so a stale index can be detected with
+// matches(). The file is
+//
+//   "VDIX", u4 version, u4 kind, u8 source size, i8 source mtime,
+//   u8 source hash, u8 value count, then
+//   strings: u8 byte count, bytes, u4 value end offsets, u8 slot count, u4 slots
+//   numbers: u8 key count, i8 or f8 sorted values, u4 data IDs
+//
+// all little-endian.
+class DictionaryIndex {
+public:
+    enum class Kind : uint32_t {
+        kStrings = 0,
+        kIntegers = 1,
+        kReals = 2,
+    };
+
+    DictionaryIndex() = default;
+
+    // Decode every value of the dictionary file once and index it. Throws
+    // std::runtime_error for dictionaries of 2^32 - 1 values or more, or of
+    // 4 GiB of string bytes or more.
+    static DictionaryIndex build(const std::string& dictionary_path);
+
+    // Throws std::runtime_error if the file cannot be read or is not an index
+    static DictionaryIndex load(const std::string& path);
+    void save(const std::string& path) const;
+
+    // Whether the dictionary file is still the one the index was built from
+    bool matches(const std::string& dictionary_path) const { return source_key(dictionary_path) == m_source; }
+
+    Kind kind() const { return m_kind; }
+    uint64_t size() const { return m_size; }
+
+    // Data ID of a value given as text: the UTF-8 string itself for string
+    // dictionaries, the number in decimal for numeric ones
+    std::optional<uint64_t> find(std::string_view value) const;
+
+    // Data ID of a number; integers are found in real dictionaries and
+    // integral reals in integer ones
+    std::optional<uint64_t> find_integer(int64_t value) const;
+    std::optional<uint64_t> find_real(double value) const;
+
+private:
+    std::string_view string_value(uint32_t id) const;
+    void insert_string(uint32_t id);
+
+    Kind m_kind = Kind::kStrings;
+    SourceKey m_source;
+    uint64_t m_size = 0;
+
+    // kStrings: value i spans [m_ends[i - 1], m_ends[i]) of m_bytes
+    std::string m_bytes;
+    std::vector<uint32_t> m_ends;
+    std::vector<uint32_t> m_slots;  // data ID + 1, 0 for an empty slot
+
+    // kIntegers and kReals, sorted by value
+    std::vector<int64_t> m_integers;
+    std::vector<double> m_reals;
+    std::vector<uint32_t> m_ids;
+};
+
+#endif  // DICTIONARY_INDEX_H_
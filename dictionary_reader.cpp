@@ -0,0 +1,247 @@
+#include "dictionary_reader.h"
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "kaitai/exceptions.h"
+#include "stats.h"
+#include "utf16.h"
+
+DictionaryReader::DictionaryReader(const std::string& path) {
+    Stats::Timer open_timer(Stats::kOpen);
+    if (!m_file.open(path)) {
+        throw std::runtime_error("Error opening file: " + path);
+    }
+    open_timer.stop();
+    Stats::Timer parse_timer(Stats::kParse);
+    m_stream.reset(new kaitai::kstream(m_file.data(), m_file.size()));
+    m_dictionary.reset(new column_data_dictionary_t(m_stream.get(), nullptr, nullptr, column_data_dictionary_t::READ_MODE_LAZY));
+
+    if (is_string()) {
+        auto string_data = static_cast<column_data_dictionary_t::string_data_t*>(m_dictionary->data());
+
+        // Only the header of the record handle vector is read here, see
+        // dictionary_record_handles_vector in dictionary.ksy
+        m_stream->seek(string_data->dictionary_record_handles_vector_info_ofs());
+        m_size = m_stream->read_u8le();
+        std::string element_size = m_stream->read_bytes(4);
+        if (element_size != std::string("\x08\x00\x00\x00", 4)) {
+            throw kaitai::validation_not_equal_error<std::string>(std::string("\x08\x00\x00\x00", 4), element_size, m_stream.get(), std::string("/types/dictionary_record_handles_vector/seq/1"));
+        }
+        m_handles_ofs = m_stream->pos();
+
+        auto pages = string_data->dictionary_pages();
+        m_compressed_pages.resize(pages->size());
+        for (uint32_t page_id = 0; page_id < pages->size(); page_id++) {
+            auto page = pages->at(page_id);
+            m_pages.push_back({page_id, page->page_compressed() != 0, page->page_start_index(), page->page_string_count(),
+                               page->len_string_store_buffer()});
+        }
+    } else if (dictionary_type() == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_LONG ||
+               dictionary_type() == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_REAL) {
+        auto number_data = static_cast<column_data_dictionary_t::number_data_t*>(m_dictionary->data());
+        m_size = number_data->vector_of_vectors_info()->num_values();
+    }
+}
+
+std::string DictionaryReader::get(uint64_t id) {
+    if (id >= m_size) {
+        throw std::out_of_range("data ID " + std::to_string(id) + " out of range, dictionary has " + std::to_string(m_size) + " values");
+    }
+    if (is_string()) {
+        return get_string(id);
+    }
+    char number[kMaxNumberSize];
+    return std::string(number, format_number_value(id, number));
+}
+
+std::vector<std::string> DictionaryReader::get(const std::vector<uint64_t>& ids) {
+    std::vector<size_t> order(ids.size());
+    std::iota(order.begin(), order.end(), 0);
+    // Pages hold consecutive ID ranges, so sorting by ID groups the lookups by page
+    std::sort(order.begin(), order.end(), [&ids](size_t a, size_t b) { return ids[a] < ids[b]; });
+
+    std::vector<std::string> values(ids.size());
+    for (size_t i : order) {
+        values[i] = get(ids[i]);
+    }
+    return values;
+}
+
+void DictionaryReader::decode_page(uint32_t page_id, DecodedRecords& records) {
+    if (page_id >= m_pages.size()) {
+        throw std::out_of_range("page " + std::to_string(page_id) + " out of range, dictionary has " + std::to_string(m_pages.size()) + " pages");
+    }
+    const PageInfo& info = m_pages[page_id];
+    records.clear();
+    if (!info.compressed) {
+        auto string_data = static_cast<column_data_dictionary_t::string_data_t*>(m_dictionary->data());
+        auto page = string_data->dictionary_pages()->at(page_id);
+        decode_uncompressed_page(static_cast<column_data_dictionary_t::uncompressed_strings_t*>(page->string_store()), records);
+        return;
+    }
+    std::vector<uint32_t> offsets = record_offsets(info.first_id, std::min(info.value_count, m_size - std::min(m_size, info.first_id)));
+    decode_records(compressed_page(page_id), page_id, RecordOffsets{offsets.data(), offsets.size()}, 0, offsets.size(), DecodeOptions(), records);
+}
+
+void DictionaryReader::filter(const StringPredicate& predicate, const std::function<void(uint64_t, std::string_view)>& visitor) {
+    if (!is_string()) {
+        for_each([&](uint64_t id, std::string_view value) {
+            if (predicate.matches(value)) visitor(id, value);
+        });
+        return;
+    }
+
+    auto string_data = static_cast<column_data_dictionary_t::string_data_t*>(m_dictionary->data());
+    DecodedRecords records;
+    for (const PageInfo& info : m_pages) {
+        auto page = string_data->dictionary_pages()->at(info.page_id);
+        if (!info.compressed) {
+            auto store = static_cast<column_data_dictionary_t::uncompressed_strings_t*>(page->string_store());
+            if (!uncompressed_page_can_match(predicate, store->used_character_bytes())) continue;
+            decode_page(info.page_id, records);
+            for (size_t i = 0; i < records.size(); i++) {
+                if (predicate.matches(records[i])) visitor(info.first_id + i, records[i]);
+            }
+            continue;
+        }
+
+        auto store = static_cast<column_data_dictionary_t::compressed_strings_t*>(page->string_store());
+        CompressedMatcher matcher(predicate, decompress_encode_array(*store->encode_array()));
+        if (!matcher.page_can_match()) continue;
+        if (!matcher.exact()) {
+            decode_page(info.page_id, records);
+            for (size_t i = 0; i < records.size(); i++) {
+                if (predicate.matches(records[i])) visitor(info.first_id + i, records[i]);
+            }
+            continue;
+        }
+
+        // Compare code bits and decode only the records that match
+        const CompressedPage& compressed = compressed_page(info.page_id);
+        std::vector<uint32_t> offsets = record_offsets(info.first_id, std::min(info.value_count, m_size - std::min(m_size, info.first_id)));
+        for (size_t i = 0; i < offsets.size(); i++) {
+            uint32_t end_bit = i + 1 < offsets.size() ? offsets[i + 1] : compressed.total_bits;
+            compressed.check_record_bits(info.page_id, offsets[i], end_bit);
+            if (matcher.record_matches(compressed.bitstream, offsets[i], end_bit)) {
+                visitor(info.first_id + i, compressed.decoder->decode_substring(compressed.bitstream, offsets[i], end_bit));
+            }
+        }
+    }
+}
+
+DictionaryReader::RecordHandle DictionaryReader::record_handle(uint64_t id) {
+    m_stream->seek(m_handles_ofs + id * 8);
+    RecordHandle handle;
+    handle.bit_or_byte_offset = m_stream->read_u4le();
+    handle.page_id = m_stream->read_u4le();
+    return handle;
+}
+
+std::vector<uint32_t> DictionaryReader::record_offsets(uint64_t first_id, uint64_t count) {
+    m_stream->seek(m_handles_ofs + first_id * 8);
+    std::string storage;
+    std::string_view bytes = m_stream->read_bytes_view(count * 8, storage);
+    std::vector<uint32_t> offsets(count);
+    for (uint64_t i = 0; i < count; i++) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(bytes.data()) + i * 8;
+        offsets[i] = p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+    return offsets;
+}
+
+const CompressedPage& DictionaryReader::compressed_page(uint32_t page_id) {
+    auto& page = m_compressed_pages[page_id];
+    if (!page) {
+        auto string_data = static_cast<column_data_dictionary_t::string_data_t*>(m_dictionary->data());
+        page.reset(new CompressedPage(static_cast<column_data_dictionary_t::compressed_strings_t*>(string_data->dictionary_pages()->at(page_id)->string_store())));
+    }
+    return *page;
+}
+
+std::string DictionaryReader::get_string(uint64_t id) {
+    auto string_data = static_cast<column_data_dictionary_t::string_data_t*>(m_dictionary->data());
+    auto pages = string_data->dictionary_pages();
+    RecordHandle handle = record_handle(id);
+    if (handle.page_id >= pages->size()) {
+        throw std::runtime_error("record handle of data ID " + std::to_string(id) + " points to missing page " + std::to_string(handle.page_id));
+    }
+    auto page = pages->at(handle.page_id);
+
+    if (page->page_compressed()) {
+        const CompressedPage& compressed = compressed_page(handle.page_id);
+        // A record ends where the next record of the same page starts
+        uint32_t end_bit = (id + 1 < page->page_start_index() + page->page_string_count())
+            ? record_handle(id + 1).bit_or_byte_offset
+            : compressed.total_bits;
+        compressed.check_record_bits(handle.page_id, handle.bit_or_byte_offset, end_bit);
+        return compressed.decoder->decode_substring(compressed.bitstream, handle.bit_or_byte_offset, end_bit);
+    }
+
+    // Uncompressed records are null-terminated UTF-16LE strings at a character offset
+    auto store = static_cast<column_data_dictionary_t::uncompressed_strings_t*>(page->string_store());
+    std::string_view bytes = store->used_character_bytes();
+    size_t begin = std::min<size_t>(static_cast<size_t>(handle.bit_or_byte_offset) * 2, bytes.size());
+    size_t end = begin;
+    while (end + 1 < bytes.size() && (bytes[end] != 0 || bytes[end + 1] != 0)) {
+        end += 2;
+    }
+    std::string value(utf8_max_size((end - begin) / 2), '\0');
+    value.resize(utf16le_to_utf8(bytes.data() + begin, (end - begin) / 2, &value[0]));
+    return value;
+}
+
+size_t DictionaryReader::format_number_value(uint64_t id, char* out) {
+    auto number_data = static_cast<column_data_dictionary_t::number_data_t*>(m_dictionary->data());
+    auto vector_info = number_data->vector_of_vectors_info();
+    if (vector_info->is_int32()) {
+        return format_number(vector_info->values_int32()->at(id), out);
+    } else if (vector_info->is_int64()) {
+        return format_number(vector_info->values_int64()->at(id), out);
+    }
+    return format_number(vector_info->values_float64()->at(id), out);
+}
+
+DictionaryReader::const_iterator::const_iterator(DictionaryReader* reader, uint64_t id) : m_reader(reader), m_id(id) {
+    load();
+}
+
+std::string_view DictionaryReader::const_iterator::operator*() const {
+    if (m_reader->is_string()) {
+        return m_records[m_id - m_page_first];
+    }
+    return std::string_view(m_number, m_number_size);
+}
+
+DictionaryReader::const_iterator& DictionaryReader::const_iterator::operator++() {
+    m_id++;
+    load();
+    return *this;
+}
+
+void DictionaryReader::const_iterator::load() {
+    if (m_id >= m_reader->size()) return;
+    if (!m_reader->is_string()) {
+        m_number_size = m_reader->format_number_value(m_id, m_number);
+        return;
+    }
+    if (m_page_loaded && m_id < m_page_first + m_records.size()) return;
+
+    // Pages are in data ID order: move forward to the page holding m_id
+    const auto& pages = m_reader->pages();
+    size_t page = m_page_loaded ? m_page + 1 : 0;
+    while (page < pages.size() && m_id >= pages[page].first_id + pages[page].value_count) {
+        page++;
+    }
+    if (page == pages.size() || m_id < pages[page].first_id) {
+        throw std::runtime_error("no page holds data ID " + std::to_string(m_id));
+    }
+    m_reader->decode_page(static_cast<uint32_t>(page), m_records);
+    m_page = page;
+    m_page_first = pages[page].first_id;
+    m_page_loaded = true;
+    if (m_id - m_page_first >= m_records.size()) {
+        throw std::runtime_error("page " + std::to_string(page) + " holds fewer strings than its header says");
+    }
+}
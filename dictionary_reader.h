@@ -0,0 +1,154 @@
+#ifndef DICTIONARY_READER_H_
+#define DICTIONARY_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "kaitai/kaitaistream.h"
+#include "column_data_dictionary.h"
+#include "mapped_file.h"
+#include "output_writer.h"
+#include "page_decoder.h"
+#include "string_filter.h"
+
+// Random access and sequential decoding of the values of a .dictionary file
+// by data ID, where the ID is the 0-based position of the value in the
+// dictionary (page_start_index + the position inside the page).
+//
+// The file is mapped and parsed in READ_MODE_LAZY, so opening it only touches
+// the page headers. get() reads the record handle of the ID straight from the
+// mapped handle vector and decodes just that record; a page's store and its
+// Huffman decoder are loaded the first time one of its records is requested.
+// decode_page(), for_each() and the iterators decode whole pages at a time.
+// Numbers are returned as text the way format_number() writes them.
+// Not thread-safe.
+class DictionaryReader {
+public:
+    // Header of one page of a string dictionary
+    struct PageInfo {
+        uint32_t page_id;
+        bool compressed;
+        uint64_t first_id;    // data ID of the page's first value
+        uint64_t value_count;
+        uint64_t store_bytes; // size of the compressed or UTF-16 string buffer
+    };
+
+    // Input iterator over every value in data ID order. Dereferencing gives a
+    // view that stays valid until the iterator is advanced or destroyed.
+    class const_iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = std::string_view;
+
+        const_iterator() = default;
+
+        uint64_t id() const { return m_id; }
+        std::string_view operator*() const;
+        const_iterator& operator++();
+        bool operator==(const const_iterator& other) const { return m_id == other.m_id; }
+        bool operator!=(const const_iterator& other) const { return m_id != other.m_id; }
+
+    private:
+        friend class DictionaryReader;
+        const_iterator(DictionaryReader* reader, uint64_t id);
+        void load();
+
+        DictionaryReader* m_reader = nullptr;
+        uint64_t m_id = 0;
+        size_t m_page = 0;          // index into pages() of the decoded page
+        uint64_t m_page_first = 0;  // data ID of m_records[0]
+        bool m_page_loaded = false;
+        DecodedRecords m_records;
+        char m_number[kMaxNumberSize];
+        size_t m_number_size = 0;
+    };
+
+    // Throws std::runtime_error if the file cannot be opened, and the kaitai
+    // exceptions if it cannot be parsed.
+    explicit DictionaryReader(const std::string& path);
+
+    column_data_dictionary_t::dictionary_types_t dictionary_type() const { return m_dictionary->dictionary_type(); }
+    bool is_string() const { return dictionary_type() == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_STRING; }
+
+    // Number of values (data IDs) in the dictionary
+    uint64_t size() const { return m_size; }
+
+    // Page headers of a string dictionary, empty for numeric ones
+    const std::vector<PageInfo>& pages() const { return m_pages; }
+
+    // Value of one data ID as UTF-8. Numbers are formatted the way std::ostream
+    // prints their stored type, so integers are exact. Throws std::out_of_range
+    // for IDs >= size().
+    std::string get(uint64_t id);
+
+    // Values of several data IDs, in the order of `ids`. IDs are decoded grouped
+    // by page so each page's decoder is built once and stays hot.
+    std::vector<std::string> get(const std::vector<uint64_t>& ids);
+
+    // Decode every value of one page of a string dictionary into records, in
+    // data ID order starting at pages()[page_id].first_id. Throws
+    // std::out_of_range for a missing page.
+    void decode_page(uint32_t page_id, DecodedRecords& records);
+
+    // Call visitor(id, value) with a std::string_view for every value, in data
+    // ID order. The view is only valid during the call.
+    template <typename Visitor>
+    void for_each(Visitor&& visitor) {
+        if (is_string()) {
+            DecodedRecords records;
+            for (const PageInfo& page : m_pages) {
+                decode_page(page.page_id, records);
+                for (size_t i = 0; i < records.size(); i++) {
+                    visitor(page.first_id + i, records[i]);
+                }
+            }
+            return;
+        }
+        char number[kMaxNumberSize];
+        for (uint64_t id = 0; id < m_size; id++) {
+            visitor(id, std::string_view(number, format_number_value(id, number)));
+        }
+    }
+
+    // Call visitor(id, value) for every value matching the predicate, in data
+    // ID order. Pages and records that cannot match are rejected before they
+    // are decoded, see string_filter.h; numbers are tested as text.
+    void filter(const StringPredicate& predicate, const std::function<void(uint64_t, std::string_view)>& visitor);
+
+    const_iterator begin() { return const_iterator(this, 0); }
+    const_iterator end() { return const_iterator(this, m_size); }
+
+    column_data_dictionary_t& dictionary() { return *m_dictionary; }
+
+private:
+    struct RecordHandle {
+        uint32_t bit_or_byte_offset;
+        uint32_t page_id;
+    };
+
+    RecordHandle record_handle(uint64_t id);
+    // bit_or_byte_offset of the handles of `count` consecutive data IDs
+    std::vector<uint32_t> record_offsets(uint64_t first_id, uint64_t count);
+    const CompressedPage& compressed_page(uint32_t page_id);
+    std::string get_string(uint64_t id);
+    size_t format_number_value(uint64_t id, char* out);
+
+    MappedFile m_file;
+    std::unique_ptr<kaitai::kstream> m_stream;
+    std::unique_ptr<column_data_dictionary_t> m_dictionary;
+    uint64_t m_size = 0;
+    uint64_t m_handles_ofs = 0;
+    std::vector<PageInfo> m_pages;
+    std::vector<std::unique_ptr<CompressedPage>> m_compressed_pages;
+};
+
+#endif  // DICTIONARY_READER_H_
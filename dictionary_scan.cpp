@@ -0,0 +1,103 @@
+#include "dictionary_scan.h"
+
+#include <fstream>
+#include <stdexcept>
+
+#include "kaitai/kaitaistream.h"
+#include "stats.h"
+
+namespace {
+
+// Every seek refills the stream buffer, so keep it small: headers are a few
+// hundred bytes apart from the next skipped payload
+constexpr size_t kScanBufferSize = 4096;
+
+const char* type_name(column_data_dictionary_t::dictionary_types_t type) {
+    switch (type) {
+    case column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_LONG: return "long";
+    case column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_REAL: return "real";
+    case column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_STRING: return "string";
+    default: return "invalid";
+    }
+}
+
+DictionaryInfo scan_headers(const std::string& path) {
+    Stats::Timer open_timer(Stats::kOpen);
+    std::vector<char> buffer(kScanBufferSize);
+    std::ifstream is;
+    is.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    is.open(path, std::ifstream::binary);
+    if (!is) {
+        throw std::runtime_error("Error opening file: " + path);
+    }
+    kaitai::kstream ks(&is);
+    open_timer.stop();
+
+    Stats::Timer parse_timer(Stats::kParse);
+    DictionaryInfo info;
+    info.path = path;
+    info.file_bytes = ks.size();
+    column_data_dictionary_t dictionary(&ks, nullptr, nullptr, column_data_dictionary_t::READ_MODE_HEADERS);
+    info.type = dictionary.dictionary_type();
+
+    uint64_t end = 0; // where the data the headers describe ends
+    if (info.type == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_STRING) {
+        auto string_data = static_cast<column_data_dictionary_t::string_data_t*>(dictionary.data());
+        auto layout = string_data->page_layout_information();
+        info.values = layout->store_string_count();
+        info.store_compressed = layout->f_store_compressed() != 0;
+        info.longest_string = layout->store_longest_string();
+        auto pages = string_data->dictionary_pages();
+        for (uint32_t page_id = 0; page_id < pages->size(); page_id++) {
+            auto page = pages->at(page_id);
+            info.pages.push_back({page_id, page->page_compressed() != 0, page->page_start_index(), page->page_string_count(),
+                                  page->len_string_store_buffer()});
+        }
+        // Only the element count of the record handle vector, see dictionary_record_handles_vector
+        ks.seek(string_data->dictionary_record_handles_vector_info_ofs());
+        const uint64_t vector_start = ks.pos(); // before the count is read
+        end = vector_start + 12 + ks.read_u8le() * 8;
+    } else if (info.type == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_LONG ||
+               info.type == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_REAL) {
+        auto vector_info = static_cast<column_data_dictionary_t::number_data_t*>(dictionary.data())->vector_of_vectors_info();
+        info.values = vector_info->num_values();
+        info.element_size = vector_info->element_size();
+        end = ks.pos();
+    }
+    if (end > info.file_bytes) {
+        throw std::runtime_error(path + " is truncated: headers describe " + std::to_string(end) + " bytes, the file has " +
+                                 std::to_string(info.file_bytes));
+    }
+    Stats::add_file(info.file_bytes, 0);
+    return info;
+}
+
+} // namespace
+
+DictionaryInfo scan_dictionary(const std::string& path) {
+    try {
+        return scan_headers(path);
+    } catch (const std::ios_base::failure&) {
+        // The stream ran out in the middle of a header
+        throw std::runtime_error(path + " is truncated");
+    }
+}
+
+void write_info_json(const DictionaryInfo& info, std::ostream& out) {
+    out << "{\"path\": " << json_string(info.path) << ", \"file_bytes\": " << info.file_bytes
+        << ", \"type\": \"" << type_name(info.type) << "\", \"values\": " << info.values;
+    if (info.type == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_STRING) {
+        out << ", \"store_compressed\": " << (info.store_compressed ? "true" : "false")
+            << ", \"longest_string\": " << info.longest_string << ", \"page_count\": " << info.pages.size() << ", \"pages\": [";
+        for (size_t i = 0; i < info.pages.size(); i++) {
+            const DictionaryReader::PageInfo& page = info.pages[i];
+            out << (i ? ", " : "") << "{\"compressed\": " << (page.compressed ? "true" : "false")
+                << ", \"first_id\": " << page.first_id << ", \"values\": " << page.value_count
+                << ", \"store_bytes\": " << page.store_bytes << "}";
+        }
+        out << "]";
+    } else {
+        out << ", \"element_size\": " << info.element_size;
+    }
+    out << "}\n";
+}
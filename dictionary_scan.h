@@ -0,0 +1,34 @@
+#ifndef DICTIONARY_SCAN_H_
+#define DICTIONARY_SCAN_H_
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "column_data_dictionary.h"
+#include "dictionary_reader.h"
+
+// Header-only summary of a .dictionary file, for inventories of many files
+struct DictionaryInfo {
+    std::string path;
+    uint64_t file_bytes = 0;
+    column_data_dictionary_t::dictionary_types_t type = column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_INVALID;
+    uint64_t values = 0;
+    uint32_t element_size = 0;      // numeric dictionaries: 4 or 8
+    bool store_compressed = false;  // string dictionaries: f_store_compressed
+    int64_t longest_string = 0;     // string dictionaries: store_longest_string
+    std::vector<DictionaryReader::PageInfo> pages;
+};
+
+// Read the headers of a dictionary with READ_MODE_HEADERS through a small
+// stream buffer: page stores, numeric values and record handles are skipped
+// by seeking, so a file costs a few small reads whatever its size. Throws
+// std::runtime_error if the file cannot be opened or is shorter than its
+// headers say, and the kaitai exceptions if they do not parse.
+DictionaryInfo scan_dictionary(const std::string& path);
+
+// One JSON object on one line
+void write_info_json(const DictionaryInfo& info, std::ostream& out);
+
+#endif  // DICTIONARY_SCAN_H_
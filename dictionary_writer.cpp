@@ -0,0 +1,314 @@
+#include "dictionary_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "column_data_dictionary.h"
+#include "dictionary_reader.h"
+#include "huffman.h"
+#include "utf16.h"
+
+namespace {
+
+// Header values every sample file carries, see hash_info and compressed_strings in dictionary.ksy
+constexpr int32_t kStringHashInfo[6] = {0, 8, 64, 6, -1, -1};
+constexpr int32_t kNumberHashInfo[6] = {-1, 8, 64, 6, -1, -1};
+constexpr uint32_t kCharacterSetTypeIdentifier = 703121;
+constexpr uint32_t kMaxDecodeBits = 10;
+constexpr char kStoreBeginMark[] = "\xDD\xCC\xBB\xAA";
+constexpr char kStoreEndMark[] = "\xCD\xAB\xCD\xAB";
+
+// Offset of page_layout in a string dictionary: dictionary_type and hash_info
+constexpr std::streamoff kLayoutOffset = 4 + 6 * 4;
+constexpr size_t kLayoutSize = 8 + 1 + 8 + 8;
+
+// Bound of a page's UTF-8 bytes plus terminators, so that both its compressed
+// bit count (at most 15 bits per character) and its UTF-16 character count
+// fit the 32-bit record handle offsets
+constexpr uint64_t kMaxPageSize = std::numeric_limits<uint32_t>::max() / 16;
+
+template <typename T>
+void put_le(std::string& out, T value) {
+    uint64_t bits;
+    if constexpr (std::is_floating_point_v<T>) {
+        std::memcpy(&bits, &value, sizeof(bits));
+    } else {
+        bits = static_cast<uint64_t>(value);
+    }
+    for (size_t i = 0; i < sizeof(T); i++) {
+        out.push_back(static_cast<char>(bits >> (8 * i)));
+    }
+}
+
+std::ofstream open_output(const std::string& path) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Error opening file: " + path);
+    }
+    return out;
+}
+
+void check_written(std::ofstream& out, const std::string& path) {
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Error writing file: " + path);
+    }
+}
+
+// Appends canonical Huffman codes MSB first, as HuffmanDecoder reads them
+class BitWriter {
+public:
+    explicit BitWriter(std::string& out) : m_out(out) {}
+
+    uint64_t bits() const { return m_pos * 8 + m_pending; }
+
+    void put(uint32_t code, uint32_t length) {
+        m_acc = (m_acc << length) | code;
+        m_pending += length;
+        while (m_pending >= 8) {
+            m_pending -= 8;
+            m_out[m_pos++] = static_cast<char>(m_acc >> m_pending);
+        }
+    }
+
+    void flush() {
+        if (m_pending) m_out[m_pos++] = static_cast<char>(m_acc << (8 - m_pending));
+        m_pending = 0;
+    }
+
+private:
+    std::string& m_out;
+    size_t m_pos = 0;
+    uint64_t m_acc = 0;
+    uint32_t m_pending = 0;
+};
+
+template <typename T>
+void write_numbers(const std::string& path, column_data_dictionary_t::dictionary_types_t type, const std::vector<T>& values) {
+    std::ofstream out = open_output(path);
+    std::string bytes;
+    put_le<int32_t>(bytes, type);
+    for (int32_t element : kNumberHashInfo) put_le(bytes, element);
+    put_le<uint64_t>(bytes, values.size());
+    put_le<uint32_t>(bytes, sizeof(T));
+    for (T value : values) put_le(bytes, value);
+    out.write(bytes.data(), bytes.size());
+    check_written(out, path);
+}
+
+} // namespace
+
+StringDictionaryWriter::StringDictionaryWriter(const std::string& path, const WriterOptions& options)
+    : m_path(path), m_options(options), m_out(open_output(path)), m_frequencies(256, 0) {
+    m_options.page_strings = std::max<uint64_t>(1, m_options.page_strings);
+    std::string header;
+    put_le<int32_t>(header, column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_STRING);
+    for (int32_t element : kStringHashInfo) put_le(header, element);
+    header.append(kLayoutSize, '\0'); // rewritten by finish()
+    write(header);
+}
+
+void StringDictionaryWriter::add(std::string_view value) {
+    if (value.size() + 1 > kMaxPageSize) {
+        throw std::runtime_error("value of " + std::to_string(value.size()) + " bytes does not fit a page");
+    }
+    if (m_page_ends.size() >= m_options.page_strings || m_page_bytes.size() + m_page_ends.size() + value.size() + 1 > kMaxPageSize) {
+        write_page();
+    }
+
+    uint64_t units = 0;
+    for (size_t i = 0; i < value.size();) {
+        uint32_t cp = next_code_point(value, i);
+        units += cp >= 0x10000 ? 2 : 1;
+        if (cp > 0xFF) {
+            m_page_latin1 = false;
+        } else {
+            m_frequencies[cp]++;
+        }
+    }
+    m_longest = std::max(m_longest, units);
+    m_page_bytes.append(value);
+    m_page_ends.push_back(static_cast<uint32_t>(m_page_bytes.size()));
+}
+
+uint64_t StringDictionaryWriter::finish() {
+    write_page();
+
+    // dictionary_record_handles_vector
+    std::string bytes;
+    put_le<uint64_t>(bytes, m_offsets.size());
+    put_le<uint32_t>(bytes, 8);
+    size_t value = 0;
+    for (size_t page = 0; page < m_page_counts.size(); page++) {
+        for (uint64_t i = 0; i < m_page_counts[page]; i++, value++) {
+            put_le<uint32_t>(bytes, m_offsets[value]);
+            put_le<uint32_t>(bytes, static_cast<uint32_t>(page));
+            if (bytes.size() >= (1 << 20)) {
+                write(bytes);
+                bytes.clear();
+            }
+        }
+    }
+    write(bytes);
+
+    write_layout();
+    check_written(m_out, m_path);
+    m_out.close();
+    return m_offsets.size();
+}
+
+void StringDictionaryWriter::write_page() {
+    if (m_page_ends.empty()) return;
+    const bool has_symbols = std::any_of(m_frequencies.begin(), m_frequencies.end(), [](uint64_t f) { return f != 0; });
+    if (m_options.compress && m_page_latin1 && has_symbols) {
+        write_compressed_page();
+        m_any_compressed = true;
+    } else {
+        write_uncompressed_page();
+    }
+    m_page_counts.push_back(m_page_ends.size());
+    m_page_bytes.clear();
+    m_page_ends.clear();
+    m_page_latin1 = true;
+    std::fill(m_frequencies.begin(), m_frequencies.end(), 0);
+}
+
+void StringDictionaryWriter::write_compressed_page() {
+    const std::vector<uint8_t> lengths = build_code_lengths(m_frequencies, HuffmanDecoder::kMaxCodeLength);
+
+    const CanonicalCodes codes = canonical_codes(lengths);
+    const uint32_t max_length = *std::max_element(lengths.begin(), lengths.end());
+    uint64_t total_bits = 0;
+    for (int s = 0; s < 256; s++) {
+        total_bits += m_frequencies[s] * lengths[s];
+    }
+
+    // The samples allocate whole 16-bit words plus 4 bytes
+    const uint64_t buffer_size = total_bits / 16 * 2 + 4;
+    std::string buffer(buffer_size, '\0');
+    BitWriter bits(buffer);
+    std::string_view page = m_page_bytes;
+    size_t begin = 0;
+    for (uint32_t end : m_page_ends) {
+        m_offsets.push_back(static_cast<uint32_t>(bits.bits()));
+        std::string_view value = page.substr(begin, end - begin);
+        for (size_t i = 0; i < value.size();) {
+            uint32_t cp = next_code_point(value, i);
+            bits.put(codes.code[cp], codes.length[cp]);
+        }
+        begin = end;
+    }
+    bits.flush();
+    // Stored as little-endian 16-bit words: logical byte k lives at k ^ 1
+    for (size_t k = 0; k + 1 < buffer.size(); k += 2) {
+        std::swap(buffer[k], buffer[k + 1]);
+    }
+
+    std::string header;
+    put_le<uint64_t>(header, 1); // page_mask
+    put_le<uint8_t>(header, 0);  // page_contains_nulls
+    put_le<uint64_t>(header, m_offsets.size() - m_page_ends.size());
+    put_le<uint64_t>(header, m_page_ends.size());
+    put_le<uint8_t>(header, 1);
+    header.append(kStoreBeginMark, 4);
+    put_le<uint32_t>(header, static_cast<uint32_t>(total_bits));
+    put_le<uint32_t>(header, kCharacterSetTypeIdentifier);
+    put_le<uint64_t>(header, buffer_size);
+    put_le<uint8_t>(header, 0); // character_set_used
+    put_le<uint32_t>(header, std::min(max_length, kMaxDecodeBits));
+    for (uint8_t packed : compress_encode_array(lengths)) put_le(header, packed);
+    put_le<uint64_t>(header, buffer_size);
+    write(header);
+    write(buffer);
+    write(std::string(kStoreEndMark, 4));
+}
+
+void StringDictionaryWriter::write_uncompressed_page() {
+    // NUL-terminated UTF-16LE values; record handles hold character offsets
+    std::string buffer;
+    std::string_view page = m_page_bytes;
+    uint64_t units = 0;
+    size_t begin = 0;
+    for (uint32_t end : m_page_ends) {
+        m_offsets.push_back(static_cast<uint32_t>(units));
+        units += utf8_to_utf16le(page.substr(begin, end - begin), buffer) + 1;
+        buffer.append(2, '\0');
+        begin = end;
+    }
+
+    std::string header;
+    put_le<uint64_t>(header, 0); // page_mask
+    put_le<uint8_t>(header, 0);  // page_contains_nulls
+    put_le<uint64_t>(header, m_offsets.size() - m_page_ends.size());
+    put_le<uint64_t>(header, m_page_ends.size());
+    put_le<uint8_t>(header, 0);
+    header.append(kStoreBeginMark, 4);
+    put_le<uint64_t>(header, 0); // remaining_store_available
+    put_le<uint64_t>(header, units);
+    put_le<uint64_t>(header, buffer.size());
+    write(header);
+    write(buffer);
+    write(std::string(kStoreEndMark, 4));
+}
+
+void StringDictionaryWriter::write_layout() {
+    std::string layout;
+    put_le<int64_t>(layout, m_offsets.size());
+    put_le<int8_t>(layout, m_any_compressed ? 1 : 0);
+    put_le<int64_t>(layout, m_longest);
+    put_le<int64_t>(layout, m_page_counts.size());
+    m_out.seekp(kLayoutOffset);
+    write(layout);
+}
+
+void StringDictionaryWriter::write(const std::string& bytes) {
+    if (!m_out.write(bytes.data(), bytes.size())) {
+        throw std::runtime_error("Error writing file: " + m_path);
+    }
+}
+
+void write_string_dictionary(const std::string& path, const std::vector<std::string>& values, const WriterOptions& options) {
+    StringDictionaryWriter writer(path, options);
+    for (const std::string& value : values) {
+        writer.add(value);
+    }
+    writer.finish();
+}
+
+void write_number_dictionary(const std::string& path, const std::vector<int64_t>& values) {
+    const bool fits_int32 = std::all_of(values.begin(), values.end(), [](int64_t v) {
+        return v >= std::numeric_limits<int32_t>::min() && v <= std::numeric_limits<int32_t>::max();
+    });
+    if (fits_int32) {
+        write_numbers(path, column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_LONG, std::vector<int32_t>(values.begin(), values.end()));
+    } else {
+        write_numbers(path, column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_LONG, values);
+    }
+}
+
+void write_number_dictionary(const std::string& path, const std::vector<double>& values) {
+    write_numbers(path, column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_REAL, values);
+}
+
+uint64_t reencode_dictionary(const std::string& input, const std::string& output, const WriterOptions& options) {
+    DictionaryReader reader(input);
+    if (reader.is_string()) {
+        StringDictionaryWriter writer(output, options);
+        reader.for_each([&](uint64_t, std::string_view value) { writer.add(value); });
+        return writer.finish();
+    }
+
+    auto number_data = static_cast<column_data_dictionary_t::number_data_t*>(reader.dictionary().data());
+    auto vector_info = number_data->vector_of_vectors_info();
+    if (vector_info->is_float64()) {
+        write_number_dictionary(output, std::vector<double>(vector_info->values_float64()->begin(), vector_info->values_float64()->end()));
+    } else if (vector_info->is_int64()) {
+        write_number_dictionary(output, std::vector<int64_t>(vector_info->values_int64()->begin(), vector_info->values_int64()->end()));
+    } else {
+        write_number_dictionary(output, std::vector<int64_t>(vector_info->values_int32()->begin(), vector_info->values_int32()->end()));
+    }
+    return reader.size();
+}
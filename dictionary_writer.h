@@ -0,0 +1,81 @@
+#ifndef DICTIONARY_WRITER_H_
+#define DICTIONARY_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Encoders producing .dictionary files in the layout of dictionary.ksy, for
+// generating test data of any size and for round trips through the decoder.
+
+struct WriterOptions {
+    uint64_t page_strings = 65536; // most strings per page
+    bool compress = true;          // Huffman-compress pages whose strings are all ISO-8859-1
+};
+
+// Writes a string dictionary one value at a time, in data ID order.
+//
+// Values are UTF-8. They are collected into pages of options.page_strings
+// values; a full page is encoded and written out, so memory use is one page
+// plus 4 bytes per value for the record handles written at the end. A page is
+// stored compressed, with its own canonical Huffman code over ISO-8859-1
+// bytes, when every value on it fits that character set, and as
+// NUL-terminated UTF-16LE otherwise.
+//
+// The page layout header at the start of the file is rewritten by finish();
+// a writer destroyed without finish() leaves an incomplete file. Throws
+// std::runtime_error on I/O errors.
+class StringDictionaryWriter {
+public:
+    explicit StringDictionaryWriter(const std::string& path, const WriterOptions& options = WriterOptions());
+
+    StringDictionaryWriter(const StringDictionaryWriter&) = delete;
+    StringDictionaryWriter& operator=(const StringDictionaryWriter&) = delete;
+
+    void add(std::string_view value);
+
+    // Write the last page, the record handles and the header. Returns the
+    // number of values written.
+    uint64_t finish();
+
+private:
+    void write_page();
+    void write_compressed_page();
+    void write_uncompressed_page();
+    void write_layout();
+    void write(const std::string& bytes);
+
+    std::string m_path;
+    WriterOptions m_options;
+    std::ofstream m_out;
+
+    // Values of the page being collected
+    std::string m_page_bytes;
+    std::vector<uint32_t> m_page_ends;
+    uint64_t m_page_units = 0;      // UTF-16 code units of the page, terminators included
+    bool m_page_latin1 = true;
+    std::vector<uint64_t> m_frequencies;
+
+    std::vector<uint32_t> m_offsets;     // bit_or_byte_offset of every value written
+    std::vector<uint64_t> m_page_counts; // values of every page written
+    uint64_t m_longest = 0;              // longest value in UTF-16 code units
+    bool m_any_compressed = false;
+};
+
+void write_string_dictionary(const std::string& path, const std::vector<std::string>& values,
+                             const WriterOptions& options = WriterOptions());
+
+// Numeric dictionaries. Integers are stored as int32 when every value fits,
+// as int64 otherwise; reals as float64.
+void write_number_dictionary(const std::string& path, const std::vector<int64_t>& values);
+void write_number_dictionary(const std::string& path, const std::vector<double>& values);
+
+// Decode every value of the dictionary at `input` and encode them again into
+// `output`, e.g. to change the page size or for a round trip through both
+// sides of the format. Returns the number of values written.
+uint64_t reencode_dictionary(const std::string& input, const std::string& output, const WriterOptions& options = WriterOptions());
+
+#endif  // DICTIONARY_WRITER_H_
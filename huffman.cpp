@@ -0,0 +1,501 @@
+#include "huffman.h"
+
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <unordered_map>
+
+#include "stats.h"
+
+namespace {
+
+// Append the UTF-8 form of an ISO-8859-1 code, returns the number of bytes written
+inline size_t put_utf8(char* out, uint8_t code) {
+    if (code >= 0x80) {
+        out[0] = static_cast<char>(0xC2 + (code > 0xBF));
+        out[1] = static_cast<char>((code & 0x3F) + 0x80);
+        return 2;
+    }
+    out[0] = static_cast<char>(code);
+    return 1;
+}
+
+} // namespace
+
+std::string iso88591_to_utf8(uint8_t code) {
+    std::string utf8;
+    if (code >= 0x80) {
+        utf8.push_back(static_cast<char>(0xC2 + (code > 0xBF)));
+        utf8.push_back(static_cast<char>((code & 0x3F) + 0x80));
+    } else {
+        utf8.push_back(static_cast<char>(code));
+    }
+    return utf8;
+}
+
+// Function to generate the full 256-byte Huffman array from the compact 128-byte encode_array
+std::vector<uint8_t> decompress_encode_array(const std::array<uint8_t, 128>& compressed) {
+    Stats::Timer timer(Stats::kDecompressEncodeArray);
+    std::vector<uint8_t> full_array(256, 0);
+
+    for (size_t i = 0; i < compressed.size(); i++) {
+        uint8_t byte = compressed[i];
+        full_array[2 * i] = byte & 0x0F;         // Lower nibble
+        full_array[2 * i + 1] = (byte >> 4) & 0x0F; // Upper nibble
+    }
+
+    return full_array;
+}
+
+std::array<uint8_t, 128> compress_encode_array(const std::vector<uint8_t>& lengths) {
+    std::array<uint8_t, 128> compressed{};
+    for (size_t i = 0; i < compressed.size(); i++) {
+        compressed[i] = static_cast<uint8_t>((lengths[2 * i] & 0x0F) | ((lengths[2 * i + 1] & 0x0F) << 4));
+    }
+    return compressed;
+}
+
+std::vector<uint8_t> build_code_lengths(const std::vector<uint64_t>& frequencies, uint32_t max_length) {
+    std::vector<uint8_t> lengths(256, 0);
+
+    // Plain Huffman: merge the two lightest nodes until one is left. Nodes
+    // 0..255 are the symbols, merged nodes are appended after them.
+    std::vector<int> parent(256, -1);
+    using Node = std::pair<uint64_t, int>;
+    std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+    for (int s = 0; s < 256; s++) {
+        if (frequencies[s]) queue.push({frequencies[s], s});
+    }
+    if (queue.empty()) return lengths;
+    if (queue.size() == 1) {
+        lengths[queue.top().second] = 1;
+        return lengths;
+    }
+    while (queue.size() > 1) {
+        Node a = queue.top();
+        queue.pop();
+        Node b = queue.top();
+        queue.pop();
+        int merged = static_cast<int>(parent.size());
+        parent.push_back(-1);
+        parent[a.second] = parent[b.second] = merged;
+        queue.push({a.first + b.first, merged});
+    }
+    std::vector<uint32_t> depth(parent.size(), 0);
+    for (int n = static_cast<int>(parent.size()) - 2; n >= 0; n--) {
+        if (parent[n] >= 0) depth[n] = depth[parent[n]] + 1;
+    }
+
+    // Clamp to max_length, then lengthen the deepest codes that can still grow
+    // until the Kraft sum fits, and shorten the most frequent symbols again
+    // while there is code space left
+    const uint64_t full = uint64_t(1) << max_length;
+    uint64_t kraft = 0;
+    std::vector<int> symbols;
+    for (int s = 0; s < 256; s++) {
+        if (!frequencies[s]) continue;
+        lengths[s] = static_cast<uint8_t>(std::min(depth[s], max_length));
+        kraft += full >> lengths[s];
+        symbols.push_back(s);
+    }
+    std::sort(symbols.begin(), symbols.end(), [&](int a, int b) {
+        return frequencies[a] != frequencies[b] ? frequencies[a] > frequencies[b] : a < b;
+    });
+    while (kraft > full) {
+        int deepest = -1;
+        for (int s : symbols) {
+            if (lengths[s] < max_length && (deepest < 0 || lengths[s] >= lengths[deepest])) deepest = s;
+        }
+        kraft -= full >> (lengths[deepest] + 1);
+        lengths[deepest]++;
+    }
+    for (bool shortened = true; shortened && kraft < full;) {
+        shortened = false;
+        for (int s : symbols) {
+            if (lengths[s] > 1 && kraft + (full >> lengths[s]) <= full) {
+                kraft += full >> lengths[s];
+                lengths[s]--;
+                shortened = true;
+            }
+        }
+    }
+    return lengths;
+}
+
+CanonicalCodes canonical_codes(const std::vector<uint8_t>& lengths) {
+    Stats::Timer timer(Stats::kGenerateCodes);
+    CanonicalCodes codes;
+    uint32_t count[16] = {};
+    for (int s = 0; s < 256; s++) {
+        codes.length[s] = static_cast<uint8_t>(s < static_cast<int>(lengths.size()) ? lengths[s] & 0x0F : 0);
+        count[codes.length[s]]++;
+    }
+    // First code of each length, then consecutive codes in symbol order
+    uint32_t next_code[16] = {};
+    uint32_t code = 0;
+    count[0] = 0;
+    for (int length = 1; length < 16; length++) {
+        code = (code + count[length - 1]) << 1;
+        next_code[length] = code;
+    }
+    for (int s = 0; s < 256; s++) {
+        uint32_t length = codes.length[s];
+        codes.code[s] = length ? static_cast<uint16_t>(next_code[length]++ & ((1u << length) - 1)) : 0;
+    }
+    return codes;
+}
+
+std::unordered_map<uint8_t, std::string> generate_codes(const std::vector<uint8_t>& lengths) {
+    const CanonicalCodes canonical = canonical_codes(lengths);
+    std::unordered_map<uint8_t, std::string> codes;
+    for (int s = 0; s < 256; s++) {
+        const uint32_t length = canonical.length[s];
+        if (length == 0) continue;
+        std::string& code = codes[static_cast<uint8_t>(s)];
+        for (int bit = length - 1; bit >= 0; bit--) {
+            code += (canonical.code[s] >> bit) & 1 ? '1' : '0';
+        }
+    }
+    return codes;
+}
+
+// Print Huffman codes
+void print_huffman_codes(const std::unordered_map<uint8_t, std::string>& codes) {
+    std::cout << "Huffman Codes:\n";
+    for (const auto& [character, code] : codes) {
+        std::cout << (int)character <<" - " << character << ": " << code << '\n';
+        }
+}
+
+// Build Huffman tree based on generated codes
+HuffmanTree* build_huffman_tree(const std::vector<uint8_t>& encode_array) {
+    Stats::Timer timer(Stats::kBuildTree);
+    const CanonicalCodes codes = canonical_codes(encode_array);
+    HuffmanTree* root = new HuffmanTree;
+
+    for (int s = 0; s < 256; s++) {
+        HuffmanTree* node = root;
+        for (int bit = codes.length[s] - 1; bit >= 0 && codes.length[s]; bit--) {
+            HuffmanTree*& child = (codes.code[s] >> bit) & 1 ? node->right : node->left;
+            if (!child) child = new HuffmanTree;
+            node = child;
+        }
+        if (node != root) node->c = static_cast<uint8_t>(s);
+    }
+
+    return root;
+}
+// Decode a bitstream from start to end bit positions using the Huffman tree
+std::string decode_substring(std::string_view bitstream, HuffmanTree* tree, uint32_t start_bit, uint32_t end_bit) {
+    std::string result;
+    char utf8[2];
+    const HuffmanTree* node = tree;
+    uint32_t total_bits = end_bit - start_bit;
+
+    // Adjust bit position calculation for little endian byte order
+    for (uint32_t i = 0; i < total_bits; ++i) {
+        uint32_t bit_pos = start_bit + i;
+        uint32_t byte_pos = bit_pos / 8;
+        uint32_t bit_offset = bit_pos % 8;
+
+        // Convert byte index for little endian (pair-wise)
+        byte_pos = (byte_pos & ~0x01) + (1 - (byte_pos & 0x01));
+
+        if (!node->left && !node->right) {
+            result.append(utf8, put_utf8(utf8, node->c));
+            node = tree; // Reset to the root node
+        }
+
+        // Traverse the Huffman tree based on the current bit
+        uint8_t byte = byte_pos < bitstream.size() ? bitstream[byte_pos] : 0;
+        if (byte & (1 << (7 - bit_offset))) {  // Adjusting bit offset to read from MSB to LSB
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+
+    // Append the last character if the final node is a leaf
+    if (!node->left && !node->right) {
+        result.append(utf8, put_utf8(utf8, node->c));
+    }
+
+    return result;
+}
+
+
+// Print Huffman tree in a readable format
+void print_huffman_tree(HuffmanTree* node, int indent) {
+    if (node == nullptr) return;
+
+    if (node->right) print_huffman_tree(node->right, indent + 4);
+
+    if (indent) std::cout << std::setw(indent) << ' ';
+    if (!node->left && !node->right) std::cout << node->c << '\n';
+    else std::cout << "⟨\n";
+
+    if (node->left) print_huffman_tree(node->left, indent + 4);
+}
+
+void PageBitstream::assign(std::string_view pair_swapped) {
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(pair_swapped.data());
+    const size_t size = pair_swapped.size();
+    const size_t even = size & ~static_cast<size_t>(1);
+
+    m_size_bits = static_cast<uint32_t>(size * 8);
+    m_bytes.assign(even + 2 + kPadding, 0);
+    for (size_t i = 0; i < even; i += 2) {
+        m_bytes[i] = data[i + 1];
+        m_bytes[i + 1] = data[i];
+    }
+    // The partner of a trailing odd byte lies outside the buffer and reads as zero
+    if (size != even) {
+        m_bytes[even + 1] = data[even];
+    }
+}
+
+HuffmanDecoder::HuffmanDecoder(const std::vector<uint8_t>& lengths, uint32_t ui_decode_bits)
+    : m_table_bits(0), m_max_length(0), m_min_length(0) {
+    Stats::Timer timer(Stats::kBuildTable);
+    std::fill(std::begin(m_first_code), std::end(m_first_code), 0);
+    std::fill(std::begin(m_first_index), std::end(m_first_index), 0);
+    std::fill(std::begin(m_count), std::end(m_count), 0);
+    std::fill(std::begin(m_symbols), std::end(m_symbols), 0);
+
+    for (size_t i = 0; i < lengths.size() && i < 256; i++) {
+        uint32_t length = lengths[i];
+        if (length == 0) continue;
+        m_count[length]++;
+        m_max_length = std::max(m_max_length, length);
+        m_min_length = m_min_length ? std::min(m_min_length, length) : length;
+    }
+
+    // Canonical codes: sorted by length, then symbol, counting up within a length
+    uint32_t code = 0;
+    uint32_t index = 0;
+    for (uint32_t length = 1; length <= kMaxCodeLength; length++) {
+        code = (code + m_count[length - 1]) << 1;
+        m_first_code[length] = code;
+        m_first_index[length] = index;
+        index += m_count[length];
+    }
+    std::vector<uint32_t> next_index(m_first_index, m_first_index + kMaxCodeLength + 1);
+    for (size_t i = 0; i < lengths.size() && i < 256; i++) {
+        if (lengths[i]) m_symbols[next_index[lengths[i]]++] = static_cast<uint8_t>(i);
+    }
+
+    m_table_bits = std::max(1u, std::min(m_max_length, std::max(ui_decode_bits, kDefaultTableBits)));
+    const uint32_t table_size = 1u << m_table_bits;
+
+    // Single-symbol table: symbol and code length for every table_bits prefix
+    std::vector<std::pair<uint8_t, uint8_t>> single(table_size, {0, 0});
+    for (uint32_t length = 1; length <= m_table_bits; length++) {
+        for (uint32_t k = 0; k < m_count[length]; k++) {
+            uint32_t first = (m_first_code[length] + k) << (m_table_bits - length);
+            uint32_t last = first + (1u << (m_table_bits - length));
+            for (uint32_t i = first; i < last; i++) {
+                single[i] = {m_symbols[m_first_index[length] + k], static_cast<uint8_t>(length)};
+            }
+        }
+    }
+
+    // Multi-symbol table: greedily chain the symbols that fit entirely in the prefix
+    m_table.assign(table_size, Entry{});
+    const uint32_t mask = table_size - 1;
+    for (uint32_t i = 0; i < table_size; i++) {
+        Entry& entry = m_table[i];
+        uint32_t pos = 0;
+        for (int n = 0; n < 4; n++) {
+            const auto& [symbol, length] = single[(i << pos) & mask];
+            if (length == 0 || length > m_table_bits - pos) break;
+            size_t written = put_utf8(entry.utf8 + entry.utf8_len, symbol);
+            if (n == 0) {
+                entry.first_bits = length;
+                entry.first_utf8_len = static_cast<uint8_t>(written);
+            }
+            entry.utf8_len += static_cast<uint8_t>(written);
+            pos += length;
+        }
+        entry.num_bits = static_cast<uint8_t>(pos);
+    }
+}
+
+size_t HuffmanDecoder::max_decoded_size(uint64_t bits, size_t records) const {
+    if (m_min_length == 0) return records * kOutputSlack;
+    return static_cast<size_t>(bits / m_min_length) * 2 + records * kOutputSlack;
+}
+
+uint32_t HuffmanDecoder::decode_long(uint64_t window, uint8_t& symbol) const {
+    for (uint32_t length = m_table_bits + 1; length <= m_max_length; length++) {
+        uint32_t code = static_cast<uint32_t>(window >> (64 - length));
+        uint32_t offset = code - m_first_code[length];
+        if (offset < m_count[length]) {
+            symbol = m_symbols[m_first_index[length] + offset];
+            return length;
+        }
+    }
+    return 0;
+}
+
+inline bool HuffmanDecoder::step(const PageBitstream& bitstream, uint32_t& pos, uint32_t end, char*& p) const {
+    uint64_t window = bitstream.peek(pos);
+    const Entry& entry = m_table[window >> (64 - m_table_bits)];
+    uint32_t remaining = end - pos;
+
+    if (entry.num_bits && entry.num_bits <= remaining) {
+        std::memcpy(p, entry.utf8, sizeof(entry.utf8));
+        p += entry.utf8_len;
+        pos += entry.num_bits;
+    } else if (entry.first_bits) {
+        // Near the end of the record only the first symbol may still fit
+        if (entry.first_bits > remaining) return false;
+        std::memcpy(p, entry.utf8, 2);
+        p += entry.first_utf8_len;
+        pos += entry.first_bits;
+    } else {
+        uint8_t symbol;
+        uint32_t length = decode_long(window, symbol);
+        if (length == 0 || length > remaining) return false;
+        p += put_utf8(p, symbol);
+        pos += length;
+    }
+    return true;
+}
+
+size_t HuffmanDecoder::decode(const PageBitstream& bitstream, uint32_t start_bit, uint32_t end_bit, char* out) const {
+    char* p = out;
+    uint32_t pos = start_bit;
+    end_bit = std::min(end_bit, bitstream.size_bits());
+    while (pos < end_bit && step(bitstream, pos, end_bit, p)) {
+    }
+    return static_cast<size_t>(p - out);
+}
+
+size_t HuffmanDecoder::decode_records(const PageBitstream& bitstream, const uint32_t* bounds, size_t count, char* out, uint32_t* ends) const {
+    // Every record first gets a slot of max_decoded_size() bytes so the streams
+    // never write over each other; ends[i] temporarily holds the record length.
+    struct Stream {
+        uint32_t pos = 0;
+        uint32_t end = 0;
+        char* p = nullptr;
+        char* start = nullptr;
+        size_t record = 0;
+        bool active = false;
+    };
+    Stream streams[kStreams];
+    size_t next = 0;
+    size_t slot = 0;
+    auto assign = [&](Stream& stream) {
+        stream.active = next < count;
+        if (!stream.active) return;
+        stream.record = next;
+        stream.pos = bounds[next];
+        stream.end = std::min(bounds[next + 1], bitstream.size_bits());
+        stream.start = stream.p = out + slot;
+        slot += max_decoded_size(bounds[next + 1] - bounds[next]);
+        next++;
+    };
+    for (auto& stream : streams) {
+        assign(stream);
+    }
+
+    bool active = count > 0;
+    while (active) {
+        active = false;
+        for (auto& stream : streams) {
+            if (stream.pos < stream.end) {
+                if (!step(bitstream, stream.pos, stream.end, stream.p)) stream.pos = stream.end;
+                active = true;
+            } else if (stream.active) {
+                ends[stream.record] = static_cast<uint32_t>(stream.p - stream.start);
+                assign(stream);
+                active = true;
+            }
+        }
+    }
+
+    // Compact the slots: every record moves down to follow its predecessor
+    size_t written = 0;
+    slot = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t length = ends[i];
+        std::memmove(out + written, out + slot, length);
+        written += length;
+        ends[i] = static_cast<uint32_t>(written);
+        slot += max_decoded_size(bounds[i + 1] - bounds[i]);
+    }
+    return written;
+}
+
+std::string HuffmanDecoder::decode_substring(const PageBitstream& bitstream, uint32_t start_bit, uint32_t end_bit) const {
+    std::string result(max_decoded_size(end_bit - start_bit), '\0');
+    result.resize(decode(bitstream, start_bit, end_bit, &result[0]));
+    return result;
+}
+
+namespace {
+
+struct CachedDecoder {
+    std::array<uint8_t, 128> encode_array;
+    uint32_t ui_decode_bits;
+    std::shared_ptr<const HuffmanDecoder> decoder;
+};
+
+std::mutex cache_mutex;
+std::unordered_map<uint64_t, CachedDecoder> cache;
+std::deque<uint64_t> cache_order; // keys, oldest first
+
+// FNV-1a over the encode_array and the table width hint
+uint64_t decoder_key(const std::array<uint8_t, 128>& encode_array, uint32_t ui_decode_bits) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (uint8_t byte : encode_array) {
+        hash = (hash ^ byte) * 0x100000001b3ull;
+    }
+    for (int i = 0; i < 4; i++) {
+        hash = (hash ^ ((ui_decode_bits >> (8 * i)) & 0xFF)) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+std::shared_ptr<const HuffmanDecoder> DecoderCache::get(const std::array<uint8_t, 128>& encode_array, uint32_t ui_decode_bits) {
+    const uint64_t key = decoder_key(encode_array, ui_decode_bits);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        auto it = cache.find(key);
+        if (it != cache.end() && it->second.encode_array == encode_array && it->second.ui_decode_bits == ui_decode_bits) {
+            Stats::count_decoder_cache(true);
+            return it->second.decoder;
+        }
+    }
+    Stats::count_decoder_cache(false);
+
+    // Built outside the lock; two threads missing on the same table both build it
+    auto decoder = std::make_shared<const HuffmanDecoder>(decompress_encode_array(encode_array), ui_decode_bits);
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    auto it = cache.find(key);
+    if (it == cache.end()) {
+        if (cache.size() >= kCapacity) {
+            cache.erase(cache_order.front());
+            cache_order.pop_front();
+        }
+        cache.emplace(key, CachedDecoder{encode_array, ui_decode_bits, decoder});
+        cache_order.push_back(key);
+    } else if (it->second.encode_array != encode_array || it->second.ui_decode_bits != ui_decode_bits) {
+        // A hash collision: the newer table takes the slot
+        it->second = CachedDecoder{encode_array, ui_decode_bits, decoder};
+    }
+    return decoder;
+}
+
+void DecoderCache::clear() {
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    cache.clear();
+    cache_order.clear();
+}
@@ -0,0 +1,183 @@
+#ifndef HUFFMAN_H_
+#define HUFFMAN_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Huffman Tree Node definition
+struct HuffmanTree {
+    uint8_t c;
+    HuffmanTree* left;
+    HuffmanTree* right;
+
+    HuffmanTree(uint8_t c = 0) : c(c), left(nullptr), right(nullptr) {}
+    ~HuffmanTree() {
+        delete left;
+        delete right;
+    }
+};
+
+std::string iso88591_to_utf8(uint8_t code);
+
+// Function to generate the full 256-byte Huffman array from the compact 128-byte encode_array
+std::vector<uint8_t> decompress_encode_array(const std::array<uint8_t, 128>& compressed);
+
+// Inverse of decompress_encode_array: pack 256 code lengths into 4-bit nibbles
+std::array<uint8_t, 128> compress_encode_array(const std::vector<uint8_t>& lengths);
+
+// Code lengths (256 entries, 0 = unused symbol) of a Huffman code for the
+// symbol frequencies, limited to max_length bits and complete, so the
+// canonical codes of generate_codes() fill the whole code space. A single
+// used symbol gets a 1-bit code.
+std::vector<uint8_t> build_code_lengths(const std::vector<uint64_t>& frequencies, uint32_t max_length = 15);
+
+// Canonical Huffman codes of a 256-entry code length array, assigned in
+// (length, symbol) order with integer arithmetic: symbol s has the length[s]
+// low bits of code[s], read MSB first. Unused symbols have length 0.
+struct CanonicalCodes {
+    uint16_t code[256];
+    uint8_t length[256];
+};
+
+CanonicalCodes canonical_codes(const std::vector<uint8_t>& lengths);
+
+// Huffman codes as strings of '0' and '1', for printing; see canonical_codes()
+std::unordered_map<uint8_t, std::string> generate_codes(const std::vector<uint8_t>& lengths);
+
+void print_huffman_codes(const std::unordered_map<uint8_t, std::string>& codes);
+
+// Reference decoder: pointer-based tree walked one bit at a time
+HuffmanTree* build_huffman_tree(const std::vector<uint8_t>& encode_array);
+std::string decode_substring(std::string_view bitstream, HuffmanTree* tree, uint32_t start_bit, uint32_t end_bit);
+void print_huffman_tree(HuffmanTree* node, int indent = 0);
+
+// Compressed page buffer normalized for a wide bit reader.
+//
+// On disk the bit stream is stored as little-endian 16-bit words, i.e. logical
+// byte k lives at k ^ 1. The constructor swaps every pair once and pads the
+// result with zero bytes, so peek() is a single unaligned 64-bit load and a
+// shift, with no per-bit index arithmetic.
+class PageBitstream {
+public:
+    static constexpr size_t kPadding = 8;
+
+    PageBitstream() = default;
+    explicit PageBitstream(std::string_view pair_swapped) { assign(pair_swapped); }
+
+    void assign(std::string_view pair_swapped);
+
+    // Number of stream bits, without the padding
+    uint32_t size_bits() const { return m_size_bits; }
+
+    // 64 stream bits starting at bit_pos, MSB first. At least the top 57 bits
+    // are stream bits (or zero padding past the end). bit_pos must not exceed size_bits().
+    uint64_t peek(uint32_t bit_pos) const {
+        uint64_t word;
+        std::memcpy(&word, m_bytes.data() + (bit_pos >> 3), sizeof(word));
+        return to_big_endian(word) << (bit_pos & 7);
+    }
+
+private:
+    static uint64_t to_big_endian(uint64_t word) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        return word;
+#elif defined(_MSC_VER)
+        return _byteswap_uint64(word);
+#else
+        return __builtin_bswap64(word);
+#endif
+    }
+
+    std::vector<uint8_t> m_bytes;
+    uint32_t m_size_bits = 0;
+};
+
+// Table-driven canonical Huffman decoder.
+//
+// The primary table is indexed by the next table_bits() bits of the stream and
+// resolves up to four symbols per probe. Codes longer than the table fall back
+// to a canonical first-code/count search, so any code set from the 4-bit
+// encode_array (lengths 1..15) is decoded exactly like the reference tree.
+class HuffmanDecoder {
+public:
+    static constexpr uint32_t kMaxCodeLength = 15;
+    static constexpr uint32_t kDefaultTableBits = 11;
+    static constexpr size_t kOutputSlack = 8;
+    static constexpr size_t kStreams = 4;
+
+    // lengths is the full 256-entry code length array (see decompress_encode_array),
+    // ui_decode_bits the page's hint for the primary table width.
+    explicit HuffmanDecoder(const std::vector<uint8_t>& lengths, uint32_t ui_decode_bits = 0);
+
+    uint32_t table_bits() const { return m_table_bits; }
+    uint32_t max_code_length() const { return m_max_length; }
+    uint32_t min_code_length() const { return m_min_length; }
+
+    // Upper bound of UTF-8 bytes written by decode() for a record of `bits` bits,
+    // or by decode_records() for `records` records totalling `bits` bits,
+    // including the slack the kernel needs for its 8-byte stores.
+    size_t max_decoded_size(uint64_t bits, size_t records = 1) const;
+
+    // Decode [start_bit, end_bit) of a compressed page into `out` as UTF-8.
+    // `out` must hold max_decoded_size(end_bit - start_bit) bytes. Returns the
+    // number of bytes written.
+    size_t decode(const PageBitstream& bitstream, uint32_t start_bit, uint32_t end_bit, char* out) const;
+
+    std::string decode_substring(const PageBitstream& bitstream, uint32_t start_bit, uint32_t end_bit) const;
+
+    // Decode `count` consecutive records, record i spanning [bounds[i], bounds[i + 1]),
+    // advancing kStreams records at once so the table lookups of independent
+    // streams overlap. Records are written back to back into `out`, which must
+    // hold max_decoded_size(bounds[count] - bounds[0], count) bytes; ends[i]
+    // receives the end offset of record i in `out`. Returns the bytes written.
+    size_t decode_records(const PageBitstream& bitstream, const uint32_t* bounds, size_t count, char* out, uint32_t* ends) const;
+
+private:
+    struct Entry {
+        char utf8[8];           // UTF-8 bytes of every symbol resolved by this entry
+        uint8_t num_bits;       // bits consumed by all symbols
+        uint8_t utf8_len;       // bytes used in utf8
+        uint8_t first_bits;     // bits consumed by the first symbol, 0 for long/invalid codes
+        uint8_t first_utf8_len; // bytes of the first symbol in utf8
+    };
+
+    // Decode the next probe of a stream at `pos` into `p`, advancing both.
+    // Returns false when no further symbol fits before `end`.
+    bool step(const PageBitstream& bitstream, uint32_t& pos, uint32_t end, char*& p) const;
+
+    // Slow path for codes longer than the primary table. Returns the code
+    // length, or 0 when the window holds no valid code.
+    uint32_t decode_long(uint64_t window, uint8_t& symbol) const;
+
+    uint32_t m_table_bits;
+    uint32_t m_max_length;
+    uint32_t m_min_length;
+    std::vector<Entry> m_table;
+
+    // Canonical code description, indexed by code length
+    uint32_t m_first_code[kMaxCodeLength + 1];
+    uint32_t m_first_index[kMaxCodeLength + 1];
+    uint32_t m_count[kMaxCodeLength + 1];
+    uint8_t m_symbols[256];
+};
+
+// Process-wide cache of built decoders, keyed by a hash of a page's 128-byte
+// encode_array and its ui_decode_bits, so pages and files sharing a code table
+// build its decoder once. Thread-safe; keeps the kCapacity most recently built
+// decoders, which stay alive while a page still holds them.
+class DecoderCache {
+public:
+    static constexpr size_t kCapacity = 64;
+
+    static std::shared_ptr<const HuffmanDecoder> get(const std::array<uint8_t, 128>& encode_array, uint32_t ui_decode_bits);
+    static void clear();
+};
+
+#endif  // HUFFMAN_H_
@@ -1,248 +1,325 @@
 #include <iostream>
 #include <vector>
-#include <unordered_map>
-#include <bitset>
 #include <algorithm>
-#include <fstream>
+#include <sstream>
 #include <string>
-#include <queue>
-#include <iomanip>
-#include "kaitai/kaitaistream.h"
-#include "column_data_dictionary.h"
-
-// Huffman Tree Node definition
-struct HuffmanTree {
-    uint8_t c;
-    HuffmanTree* left;
-    HuffmanTree* right;
-
-    HuffmanTree(uint8_t c = 0) : c(c), left(nullptr), right(nullptr) {}
-    ~HuffmanTree() {
-        delete left;
-        delete right;
+#include <filesystem>
+#include <optional>
+#include <limits>
+#include <stdexcept>
+#include <thread>
+#include "batch.h"
+#include "column_segment.h"
+#include "dictionary_index.h"
+#include "dictionary_dump.h"
+#include "dictionary_reader.h"
+#include "dictionary_scan.h"
+#include "dictionary_writer.h"
+#include "output_writer.h"
+#include "stats.h"
+
+int run_command(int argc, char* argv[]);
+
+namespace {
+
+// A count between 0 and max. std::stoul accepts a minus sign and wraps the
+// value around, so one is rejected here first.
+size_t parse_count(const std::string& text, size_t max) {
+    if (text.find('-') != std::string::npos) {
+        throw std::invalid_argument("negative");
     }
-};
-
-std::string iso88591_to_utf8(uint8_t code) {
-    std::string utf8;
-    if (code >= 0x80) {
-        utf8.push_back(static_cast<char>(0xC2 + (code > 0xBF)));
-        utf8.push_back(static_cast<char>((code & 0x3F) + 0x80));
-    } else {
-        utf8.push_back(static_cast<char>(code));
+    const unsigned long long value = std::stoull(text);
+    if (value > max) {
+        throw std::out_of_range("above " + std::to_string(max));
     }
-    return utf8;
-}
-// Function to generate the full 256-byte Huffman array from the compact 128-byte encode_array
-std::vector<uint8_t> decompress_encode_array(const std::vector<uint8_t>& compressed) {
-    std::vector<uint8_t> full_array(256, 0);
-
-    for (size_t i = 0; i < compressed.size(); i++) {
-        uint8_t byte = compressed[i];
-        full_array[2 * i] = byte & 0x0F;         // Lower nibble
-        full_array[2 * i + 1] = (byte >> 4) & 0x0F; // Upper nibble
-    }
-
-    return full_array;
+    return static_cast<size_t>(value);
 }
 
-// Function to generate Huffman codes based on codeword lengths
-std::unordered_map<uint8_t, std::string> generate_codes(const std::vector<uint8_t>& lengths) {
-    std::unordered_map<uint8_t, std::string> codes;
-    std::vector<std::pair<uint8_t, uint8_t>> sorted_lengths;
+} // namespace
 
-    // Collect only the non-zero lengths and their associated symbols
-    for (auto i = 0; i < 256; i++) {
-        if (lengths[i] != 0){
-            sorted_lengths.emplace_back(lengths[i], i);
-        }
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--stats") Stats::enable();
     }
-    // Sort by length first, then by character
-    std::sort(sorted_lengths.begin(), sorted_lengths.end(), [](const auto& a, const auto& b) {
-        return a.first != b.first ? a.first < b.first : a.second < b.second;
-    });
-
-    int code = 0;
-    int last_length = 0;
-
-    for (const auto& [length, character] : sorted_lengths) {
-        if (last_length != length) {
-            code <<= (length - last_length); // Shift code by difference in lengths
-            last_length = length;
-        }
-
-        // Generate the code string representation up to 15 bits
-        codes[character] = std::bitset<15>(code).to_string().substr(15 - length);
-        code++;
+    int status = run_command(argc, argv);
+    if (Stats::enabled()) {
+        Stats::write_json(std::cerr);
     }
-
-    return codes;
+    return status;
 }
 
-// Print Huffman codes
-void print_huffman_codes(const std::unordered_map<uint8_t, std::string>& codes) {
-    std::cout << "Huffman Codes:\n";
-    for (const auto& [character, code] : codes) {
-        std::cout << (int)character <<" - " << character << ": " << code << '\n';
-        }
-}
-
-// Build Huffman tree based on generated codes
-HuffmanTree* build_huffman_tree(const std::vector<uint8_t>& encode_array) {
-    auto codes = generate_codes(encode_array);
-// print_huffman_codes(codes);
-    HuffmanTree* root = new HuffmanTree;
-
-    for (const auto& [character, code] : codes) {
-        HuffmanTree* node = root;
-        for (char bit : code) {
-            if (bit == '0') {
-                if (!node->left) node->left = new HuffmanTree;
-                node = node->left;
+int run_command(int argc, char* argv[]) {
+    std::vector<std::string> inputs;
+    DumpOptions run;
+    std::vector<uint64_t> ids;  // print only these data IDs
+    OutputFormat format = OutputFormat::Lines;
+    std::string out_dir;        // batch mode: one output per input file in this directory
+    std::string encode_path;    // re-encode the input into this file instead of printing it
+    WriterOptions encode;
+    bool scan = false;          // print header summaries of every input instead of values
+    std::string idf_path;       // materialize the rows of this column segment through the dictionary
+    SegmentLayout layout;
+    std::vector<std::string> find_values; // look these values up instead of printing the dictionary
+    std::string index_path;     // reverse index file, loaded if it exists, otherwise built and saved
+    bool filtered = false;      // print only the values matching `predicate`
+    StringPredicate predicate;
+    bool usage_error = false;
+
+    // Numeric values are parsed with std::stoul and friends, which throw on
+    // anything that is not a number in range
+    int i = 1;
+    try {
+        for (; i < argc; i++) {
+            std::string arg = argv[i];
+            if (arg == "--reference") {
+                run.decode.use_reference = true;
+            } else if (arg == "--verify") {
+                run.decode.verify = true;
+            } else if (arg == "--threads" && i + 1 < argc) {
+                run.threads = parse_count(argv[++i], 4 * std::max(1u, std::thread::hardware_concurrency()));
+            } else if (arg == "--chunk-records" && i + 1 < argc) {
+                // No page holds more records than a u4 can count
+                run.min_records_per_chunk = std::max<size_t>(1, parse_count(argv[++i], std::numeric_limits<uint32_t>::max()));
+            } else if (arg == "--stream") {
+                run.use_stream = true;
+            } else if (arg == "--lazy") {
+                run.lazy = true;
+            } else if (arg == "--ids" && i + 1 < argc) {
+                std::istringstream list(argv[++i]);
+                std::string id;
+                while (std::getline(list, id, ',')) {
+                    ids.push_back(std::stoull(id));
+                }
+            } else if (arg == "--format" && i + 1 < argc) {
+                std::string name = argv[++i];
+                run.arrow = name == "arrow";
+                if (!run.arrow) format = parse_output_format(name);
+            } else if (arg == "--out-dir" && i + 1 < argc) {
+                out_dir = argv[++i];
+            } else if (arg == "--encode" && i + 1 < argc) {
+                encode_path = argv[++i];
+            } else if (arg == "--page-strings" && i + 1 < argc) {
+                encode.page_strings = std::max<uint64_t>(1, std::stoull(argv[++i]));
+            } else if (arg == "--uncompressed") {
+                encode.compress = false;
+            } else if (arg == "--scan") {
+                scan = true;
+            } else if (arg == "--idf" && i + 1 < argc) {
+                idf_path = argv[++i];
+            } else if (arg == "--bit-width" && i + 1 < argc) {
+                layout.bit_width = std::stoul(argv[++i]);
+            } else if (arg == "--min-data-id" && i + 1 < argc) {
+                layout.min_data_id = std::stoul(argv[++i]);
+            } else if (arg == "--first-data-id" && i + 1 < argc) {
+                layout.first_data_id = std::stoull(argv[++i]);
+            } else if (arg == "--rows" && i + 1 < argc) {
+                layout.rows = std::stoull(argv[++i]);
+            } else if (arg == "--segment-rows" && i + 1 < argc) {
+                std::istringstream list(argv[++i]);
+                std::string rows;
+                while (std::getline(list, rows, ',')) {
+                    layout.segment_rows.push_back(parse_count(rows, std::numeric_limits<size_t>::max()));
+                }
+            } else if (arg == "--find" && i + 1 < argc) {
+                find_values.push_back(argv[++i]);
+            } else if (arg == "--index" && i + 1 < argc) {
+                index_path = argv[++i];
+            } else if ((arg == "--equals" || arg == "--prefix" || arg == "--contains") && i + 1 < argc) {
+                filtered = true;
+                predicate.kind = arg == "--equals" ? MatchKind::kEquals : arg == "--prefix" ? MatchKind::kPrefix : MatchKind::kContains;
+                predicate.value = argv[++i];
+            } else if (arg == "--cache") {
+                run.cache = true;
+            } else if (arg == "--cache-dir" && i + 1 < argc) {
+                run.cache = true;
+                run.cache_dir = argv[++i];
+            } else if (arg == "--stats") {
+                // handled in main()
+            } else if (arg.rfind("--", 0) != 0) {
+                inputs.push_back(arg);
             } else {
-                if (!node->right) node->right = new HuffmanTree;
-                node = node->right;
+                usage_error = true;
+                break;
             }
         }
-        node->c = character;
+    } catch (const std::exception& e) {
+        std::cerr << "Invalid value " << argv[i] << " for " << argv[i - 1] << ": " << e.what() << std::endl;
+        usage_error = true;
     }
 
-    return root;
-}
-// Decode a bitstream from start to end bit positions using the Huffman tree
-std::string decode_substring(const std::string& bitstream, HuffmanTree* tree, uint32_t start_bit, uint32_t end_bit) {
-    std::string result;
-    const HuffmanTree* node = tree;
-    uint32_t total_bits = end_bit - start_bit;
-
-    // Adjust bit position calculation for little endian byte order
-    for (uint32_t i = 0; i < total_bits; ++i) {
-        uint32_t bit_pos = start_bit + i;
-        uint32_t byte_pos = bit_pos / 8;
-        uint32_t bit_offset = bit_pos % 8;
-
-        // Convert byte index for little endian (pair-wise)
-        byte_pos = (byte_pos & ~0x01) + (1 - (byte_pos & 0x01));
-
-        if (!node->left && !node->right) {
-            result += iso88591_to_utf8(node->c);
-            node = tree; // Reset to the root node
-        }
+    // Check for the correct number of arguments
+    if (usage_error || inputs.empty() || (out_dir.empty() && !scan && inputs.size() != 1)) {
+        std::cerr << "Usage: " << argv[0] << " [--reference] [--verify] [--threads N] [--chunk-records N] [--stream] [--lazy] [--ids <id,...>] [--format lines|nul|length|id-tab|arrow] [--cache] [--cache-dir <dir>] [--stats] <dictionary_file_path>" << std::endl;
+        std::cerr << "       " << argv[0] << " [options] --out-dir <dir> <file|dir|pattern|@list>..." << std::endl;
+        std::cerr << "       " << argv[0] << " --scan <file|dir|pattern|@list>..." << std::endl;
+        std::cerr << "       " << argv[0] << " --encode <output_file> [--page-strings N] [--uncompressed] <dictionary_file_path>" << std::endl;
+        std::cerr << "       " << argv[0] << " [--index <index_file>] [--find <value>]... <dictionary_file_path>" << std::endl;
+        std::cerr << "       " << argv[0] << " --equals|--prefix|--contains <value> [--format ...] <dictionary_file_path>" << std::endl;
+        std::cerr << "       " << argv[0] << " --idf <segment.idf> --bit-width N [--min-data-id N] [--first-data-id N] [--rows N] [--segment-rows N,...] [--format ...] <dictionary_file_path>" << std::endl;
+        return 1;
+    }
 
-        // Traverse the Huffman tree based on the current bit
-        if (bitstream[byte_pos] & (1 << (7 - bit_offset))) {  // Adjusting bit offset to read from MSB to LSB
-            node = node->right;
-        } else {
-            node = node->left;
+    // Headers only, one JSON line per file; a file that fails is reported and skipped
+    if (scan) {
+        bool failed = false;
+        try {
+            for (const std::string& input : expand_inputs(inputs)) {
+                try {
+                    write_info_json(scan_dictionary(input), std::cout);
+                } catch (const std::exception& e) {
+                    std::cerr << input << ": " << e.what() << std::endl;
+                    failed = true;
+                }
+            }
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
         }
+        return failed ? 1 : 0;
     }
 
-    // Append the last character if the final node is a leaf
-    if (!node->left && !node->right) {
-        result += iso88591_to_utf8(node->c);
+    // Decode the input and write its values back out as a new dictionary
+    if (!encode_path.empty()) {
+        if (!out_dir.empty() || !ids.empty()) {
+            std::cerr << "--encode cannot be combined with --out-dir or --ids" << std::endl;
+            return 1;
+        }
+        try {
+            reencode_dictionary(inputs.front(), encode_path, encode);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
     }
 
-    return result;
-}
-
-
-// Print Huffman tree in a readable format
-void print_huffman_tree(HuffmanTree* node, int indent = 0) {
-    if (node == nullptr) return;
-
-    if (node->right) print_huffman_tree(node->right, indent + 4);
-
-    if (indent) std::cout << std::setw(indent) << ' ';
-    if (!node->left && !node->right) std::cout << node->c << '\n';
-    else std::cout << "⟨\n";
-
-    if (node->left) print_huffman_tree(node->left, indent + 4);
-}
-
-
-int main(int argc, char* argv[]) {
-    // Check for the correct number of arguments
-    if (argc != 2) {
-        std::cerr << "Usage: " << argv[0] << " <dictionary_file_path>" << std::endl;
-        return 1;
+    // Batch mode: whole files are the tasks, each decoded on one worker
+    if (!out_dir.empty()) {
+        if (!ids.empty()) {
+            std::cerr << "--ids cannot be combined with --out-dir" << std::endl;
+            return 1;
+        }
+        try {
+            DumpOptions file_run = run;
+            file_run.threads = 1;
+            BatchReport report = run_batch(expand_inputs(inputs), out_dir, run.arrow ? ".arrow" : ".txt", run.threads,
+                [&](const std::string& input, const std::string& output) {
+                    OutputWriter writer(output, format);
+                    return dump_dictionary(input, file_run, writer);
+                });
+            print_batch_report(report, std::cerr);
+            return report.failed() ? 1 : 0;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
     }
 
-    // Read the file name from arguments
-    const char* filename = argv[1];
-
-    // Open the file and check if it opened successfully
-    std::ifstream is(filename, std::ifstream::binary);
-    if (!is) {
-        std::cerr << "Error opening file: " << filename << std::endl;
-        return 1;
+    const std::string& filename = inputs.front();
+    OutputWriter writer(1, format);
+
+    // Reverse lookups: print `id<TAB>value` for every value found
+    if (!find_values.empty() || !index_path.empty()) {
+        try {
+            // An index built from another file, or from an older version of
+            // this one, is rebuilt
+            DictionaryIndex index;
+            bool loaded = false;
+            if (!index_path.empty() && std::filesystem::exists(index_path)) {
+                index = DictionaryIndex::load(index_path);
+                loaded = index.matches(filename);
+                if (!loaded) std::cerr << index_path << " is stale, rebuilding it" << std::endl;
+            }
+            if (!loaded) {
+                index = DictionaryIndex::build(filename);
+                if (!index_path.empty()) index.save(index_path);
+            }
+            OutputWriter found(1, OutputFormat::IdTab);
+            bool missing = false;
+            for (const std::string& value : find_values) {
+                if (std::optional<uint64_t> id = index.find(value)) {
+                    found.write_record(*id, value);
+                } else {
+                    std::cerr << "not found: " << value << std::endl;
+                    missing = true;
+                }
+            }
+            found.flush();
+            return missing ? 1 : 0;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
     }
-    kaitai::kstream ks(&is);
-
-    column_data_dictionary_t dictionary(&ks);
-
-    // Checking dictionary type and processing accordingly
-    if (dictionary.dictionary_type() == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_STRING) {
-        auto stringData = static_cast<column_data_dictionary_t::string_data_t*>(dictionary.data());
-        auto pages = stringData->dictionary_pages();
-        auto record_handles = stringData->dictionary_record_handles_vector_info()->vector_of_record_handle_structures();
-        std::unordered_map<int, std::vector<int>> record_handles_map;
-        // make record_handle a map of page_id and bit_or_byte_offset
-        for (const auto& handle : *record_handles) {
-            record_handles_map[handle->page_id()].push_back(handle->bit_or_byte_offset());
+
+    // Only the values matching a predicate, with their data IDs for --format id-tab
+    if (filtered) {
+        if (run.arrow || !ids.empty()) {
+            std::cerr << "--equals, --prefix and --contains cannot be combined with --format arrow or --ids" << std::endl;
+            return 1;
         }
+        try {
+            DictionaryReader reader(filename);
+            reader.filter(predicate, [&writer](uint64_t id, std::string_view value) { writer.write_record(id, value); });
+            writer.flush();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
-        for(int page_id = 0; page_id < pages->size(); page_id++){
-            const auto& page = pages->at(page_id);
-            if(page->page_compressed()){
-                auto compressed_store = static_cast<column_data_dictionary_t::compressed_strings_t*>(page->string_store());
-                auto encode_array = compressed_store->encode_array();
-                auto store_total_bits = compressed_store->store_total_bits();
-                auto compressed_string_buffer = compressed_store->compressed_string_buffer();
-                auto ui_decode_bits = compressed_store->ui_decode_bits();
-
-                auto full_encode_array = decompress_encode_array(*encode_array);
-
-                HuffmanTree* huffman_tree = build_huffman_tree(full_encode_array);
-
-                auto it = record_handles_map.find(page_id);
-                if (it != record_handles_map.end()) {
-                    for (size_t i = 0; i < it->second.size(); i++) {
-                        uint32_t start_bit = it->second[i];
-                        uint32_t end_bit = (i + 1 < it->second.size()) ? it->second[i + 1] : store_total_bits; // end of the compressed buffer
-                        std::string decompressed = decode_substring(compressed_string_buffer, huffman_tree, start_bit, end_bit);
-// std::cout << "Decompressed string " << start_bit << "/" << end_bit << " - " << page_id << ": " << decompressed << std::endl;
-                        std::cout  << decompressed << std::endl;
-                    }
-                }
-                delete huffman_tree;
-            } else {
-                auto uncompressed_store = static_cast<column_data_dictionary_t::uncompressed_strings_t *>(page->string_store());
-                auto uncompressed = uncompressed_store->uncompressed_character_buffer();
-                // Extracting strings from the uncompressed buffer
-                std::istringstream ss(uncompressed);
-                std::string token;
-                while (std::getline(ss, token, '\0'))
-                { // assuming null-terminated strings in buffer
-// std::cout << "Uncompressed string - " << page_id << ": " << token << std::endl;
-                    std::cout << token << std::endl;
-                }
+    // Rows of a column: data IDs from the segment file, values from the dictionary
+    if (!idf_path.empty()) {
+        if (!ids.empty()) {
+            std::cerr << "--idf cannot be combined with --ids" << std::endl;
+            return 1;
+        }
+        try {
+            std::vector<uint32_t> data_ids = decode_data_ids(read_column_segments(idf_path), layout);
+            DictionaryReader reader(filename);
+            uint64_t blank = run.arrow
+                ? materialize_column_arrow(reader, data_ids, layout.first_data_id, std::filesystem::path(idf_path).stem().string(), writer)
+                : materialize_column(reader, data_ids, layout.first_data_id, writer);
+            if (blank) {
+                std::cerr << blank << " of " << data_ids.size() << " rows have data IDs outside the dictionary" << std::endl;
             }
-
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
         }
+        return 0;
+    }
 
-    } else if (dictionary.dictionary_type() == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_LONG ||
-                 dictionary.dictionary_type() == column_data_dictionary_t::DICTIONARY_TYPES_XM_TYPE_REAL)
-        {
-            // Handling numeric data
-            auto numberData = static_cast<column_data_dictionary_t::number_data_t *>(dictionary.data());
-            auto vector_info = numberData->vector_of_vectors_info();
-            const auto &vals = vector_info->values();
-
-            for (double val : *vals)
-            {
-                std::cout<< val << std::endl;
+    // Random access: decode only the requested data IDs
+    if (!ids.empty()) {
+        if (run.arrow) {
+            std::cerr << "--format arrow cannot be combined with --ids" << std::endl;
+            return 1;
+        }
+        try {
+            DictionaryReader reader(filename);
+            std::vector<std::string> values = reader.get(ids);
+            for (size_t i = 0; i < ids.size(); i++) {
+                writer.write_record(ids[i], values[i]);
             }
+            writer.flush();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
 
+    try {
+        dump_dictionary(filename, run, writer);
+    } catch (const std::exception& e) {
+        try {
+            writer.flush();
+        } catch (...) {
         }
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
     return 0;
-}
+}
\ No newline at end of file
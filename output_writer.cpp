@@ -0,0 +1,194 @@
+#include "output_writer.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+OutputFormat parse_output_format(const std::string& name) {
+    if (name == "lines") return OutputFormat::Lines;
+    if (name == "nul") return OutputFormat::Nul;
+    if (name == "length") return OutputFormat::LengthPrefixed;
+    if (name == "id-tab") return OutputFormat::IdTab;
+    throw std::invalid_argument("unknown output format: " + name);
+}
+
+OutputWriter::OutputWriter(int fd, OutputFormat format, size_t buffer_size)
+    : m_fd(fd), m_format(format), m_buffer(std::max<size_t>(buffer_size, kMaxPrefix + 1)) {}
+
+OutputWriter::OutputWriter(const std::string& path, OutputFormat format, size_t buffer_size)
+    : OutputWriter(-1, format, buffer_size) {
+#ifdef _WIN32
+    m_fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (m_fd < 0) {
+        throw std::runtime_error("Error opening output file: " + path + ": " + std::strerror(errno));
+    }
+    m_owns_fd = true;
+}
+
+OutputWriter::~OutputWriter() {
+    try {
+        flush();
+    } catch (...) {
+    }
+    if (m_owns_fd) {
+#ifdef _WIN32
+        _close(m_fd);
+#else
+        ::close(m_fd);
+#endif
+    }
+}
+
+void OutputWriter::write_record(uint64_t id, std::string_view value) {
+    const bool terminated = m_format != OutputFormat::LengthPrefixed;
+    if (kMaxPrefix + value.size() + 1 <= m_buffer.size()) {
+        reserve(kMaxPrefix + value.size() + 1);
+        char* p = m_buffer.data() + m_used;
+        p += write_prefix(id, value.size(), p);
+        std::memcpy(p, value.data(), value.size());
+        p += value.size();
+        if (terminated) *p++ = m_format == OutputFormat::Nul ? '\0' : '\n';
+        m_used = p - m_buffer.data();
+        return;
+    }
+    // Too large to copy: the buffer and its prefix go out in one writev with the value
+    reserve(kMaxPrefix);
+    m_used += write_prefix(id, value.size(), m_buffer.data() + m_used);
+    write_fd(m_buffer.data(), m_used, value.data(), value.size());
+    m_used = 0;
+    if (terminated) m_buffer[m_used++] = m_format == OutputFormat::Nul ? '\0' : '\n';
+}
+
+void OutputWriter::write_bytes(std::string_view bytes) {
+    if (bytes.empty()) return;  // may have no data pointer to copy from
+    if (bytes.size() <= m_buffer.size()) {
+        reserve(bytes.size());
+        std::memcpy(m_buffer.data() + m_used, bytes.data(), bytes.size());
+        m_used += bytes.size();
+        return;
+    }
+    write_fd(m_buffer.data(), m_used, bytes.data(), bytes.size());
+    m_used = 0;
+}
+
+char* OutputWriter::begin_record(uint64_t id, size_t max_size) {
+    reserve(kMaxPrefix + max_size + 1);
+    m_record_start = m_used + write_prefix(id, 0, m_buffer.data() + m_used);
+    return m_buffer.data() + m_record_start;
+}
+
+void OutputWriter::end_record(size_t size) {
+    if (m_format == OutputFormat::LengthPrefixed) {
+        write_prefix(0, size, m_buffer.data() + m_record_start - 4);
+    }
+    m_used = m_record_start + size;
+    if (m_format != OutputFormat::LengthPrefixed) {
+        m_buffer[m_used++] = m_format == OutputFormat::Nul ? '\0' : '\n';
+    }
+}
+
+void OutputWriter::flush() {
+    if (m_used) {
+        size_t used = m_used;
+        m_used = 0;
+        write_fd(m_buffer.data(), used);
+    }
+}
+
+void OutputWriter::reserve(size_t n) {
+    if (m_used + n <= m_buffer.size()) return;
+    flush();
+    if (n > m_buffer.size()) m_buffer.resize(n);
+}
+
+size_t OutputWriter::write_prefix(uint64_t id, size_t size, char* out) const {
+    switch (m_format) {
+    case OutputFormat::LengthPrefixed: {
+        uint32_t length = static_cast<uint32_t>(size);
+        for (int i = 0; i < 4; i++) {
+            out[i] = static_cast<char>(length >> (8 * i));
+        }
+        return 4;
+    }
+    case OutputFormat::IdTab: {
+        char* end = std::to_chars(out, out + kMaxPrefix - 1, id).ptr;
+        *end++ = '\t';
+        return end - out;
+    }
+    default:
+        return 0;
+    }
+}
+
+#ifdef _WIN32
+
+void OutputWriter::write_fd(const char* data, size_t size) {
+    while (size) {
+        int chunk = static_cast<int>(std::min<size_t>(size, 1 << 30));
+        int written = _write(m_fd, data, chunk);
+        if (written < 0) {
+            throw std::runtime_error(std::string("write failed: ") + std::strerror(errno));
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+void OutputWriter::write_fd(const char* first, size_t first_size, const char* second, size_t second_size) {
+    write_fd(first, first_size);
+    write_fd(second, second_size);
+}
+
+#else
+
+void OutputWriter::write_fd(const char* data, size_t size) {
+    while (size) {
+        ssize_t written = ::write(m_fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("write failed: ") + std::strerror(errno));
+        }
+        data += written;
+        size -= written;
+    }
+}
+
+void OutputWriter::write_fd(const char* first, size_t first_size, const char* second, size_t second_size) {
+    iovec parts[2] = {{const_cast<char*>(first), first_size}, {const_cast<char*>(second), second_size}};
+    iovec* part = parts;
+    int count = 2;
+    while (count) {
+        ssize_t written = ::writev(m_fd, part, count);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("write failed: ") + std::strerror(errno));
+        }
+        // Skip what was written, which may end inside either part
+        while (count && static_cast<size_t>(written) >= part->iov_len) {
+            written -= part->iov_len;
+            part++;
+            count--;
+        }
+        if (count) {
+            part->iov_base = static_cast<char*>(part->iov_base) + written;
+            part->iov_len -= written;
+        }
+    }
+}
+
+#endif
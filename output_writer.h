@@ -0,0 +1,90 @@
+#ifndef OUTPUT_WRITER_H_
+#define OUTPUT_WRITER_H_
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// How each value is framed in the output
+enum class OutputFormat {
+    Lines,          // value '\n'
+    Nul,            // value '\0'
+    LengthPrefixed, // u4le byte length, value
+    IdTab,          // data ID '\t' value '\n'
+};
+
+// Largest text produced by format_number()
+constexpr size_t kMaxNumberSize = 32;
+
+// Writes a number as text into out (kMaxNumberSize bytes) and returns its
+// length: integers exactly, doubles like std::ostream does (%g, precision 6)
+template <typename T>
+size_t format_number(T value, char* out) {
+    if constexpr (std::is_floating_point_v<T>) {
+        return std::to_chars(out, out + kMaxNumberSize, value, std::chars_format::general, 6).ptr - out;
+    } else {
+        return std::to_chars(out, out + kMaxNumberSize, value).ptr - out;
+    }
+}
+
+// Parses the --format names: lines, nul, length, id-tab. Throws std::invalid_argument.
+OutputFormat parse_output_format(const std::string& name);
+
+// Buffered record writer on a file descriptor.
+//
+// Records are framed into one large reusable buffer that is handed to write()
+// when full; values larger than the free space go out together with the
+// buffer in a single writev() instead of being copied. begin_record() and
+// end_record() let a decoder write a value straight into the buffer.
+// Write errors throw std::runtime_error. Not thread-safe.
+class OutputWriter {
+public:
+    static constexpr size_t kDefaultBufferSize = 1 << 20;
+
+    explicit OutputWriter(int fd = 1, OutputFormat format = OutputFormat::Lines, size_t buffer_size = kDefaultBufferSize);
+    // Creates or truncates the file at path and closes it when destroyed.
+    // Throws std::runtime_error if it cannot be opened.
+    explicit OutputWriter(const std::string& path, OutputFormat format = OutputFormat::Lines, size_t buffer_size = kDefaultBufferSize);
+    // Flushes, dropping write errors; call flush() first to see them
+    ~OutputWriter();
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    OutputFormat format() const { return m_format; }
+
+    void write_record(uint64_t id, std::string_view value);
+
+    // Start a record of at most max_size bytes and return where its value goes;
+    // end_record() closes it with the bytes actually written.
+    char* begin_record(uint64_t id, size_t max_size);
+    void end_record(size_t size);
+
+    // Append bytes as they are, without framing, e.g. for binary file formats
+    void write_bytes(std::string_view bytes);
+
+    // Hand everything buffered to the file descriptor
+    void flush();
+
+private:
+    static constexpr size_t kMaxPrefix = 24; // "<u64>\t" or the u4le length
+
+    // Make room for n more bytes, flushing or growing the buffer
+    void reserve(size_t n);
+    size_t write_prefix(uint64_t id, size_t size, char* out) const;
+    void write_fd(const char* data, size_t size);
+    void write_fd(const char* first, size_t first_size, const char* second, size_t second_size);
+
+    int m_fd;
+    bool m_owns_fd = false;
+    OutputFormat m_format;
+    std::vector<char> m_buffer;
+    size_t m_used = 0;
+    size_t m_record_start = 0; // value offset of the record opened by begin_record()
+};
+
+#endif  // OUTPUT_WRITER_H_
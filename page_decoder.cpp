@@ -0,0 +1,116 @@
+#include "page_decoder.h"
+
+#include <cstring>
+#include <stdexcept>
+
+#include "stats.h"
+#include "utf16.h"
+
+std::vector<uint32_t> group_offsets_by_page(const std::pmr::vector<column_data_dictionary_t::string_record_handle_t>& handles,
+                                            size_t page_count, std::vector<size_t>& page_begin) {
+    page_begin.assign(page_count + 1, 0);
+    for (const auto& handle : handles) {
+        if (handle.page_id() < page_count) page_begin[handle.page_id() + 1]++;
+    }
+    for (size_t p = 0; p < page_count; p++) {
+        page_begin[p + 1] += page_begin[p];
+    }
+    std::vector<uint32_t> offsets(page_begin[page_count]);
+    std::vector<size_t> next(page_begin.begin(), page_begin.end() - 1);
+    for (const auto& handle : handles) {
+        if (handle.page_id() < page_count) offsets[next[handle.page_id()]++] = handle.bit_or_byte_offset();
+    }
+    return offsets;
+}
+
+CompressedPage::CompressedPage(column_data_dictionary_t::compressed_strings_t* store, const DecodeOptions& options)
+    : buffer(store->compressed_string_buffer()),
+      bitstream(buffer),
+      total_bits(store->store_total_bits()),
+      decoder(DecoderCache::get(*store->encode_array(), store->ui_decode_bits())) {
+    if (options.use_reference || options.verify) {
+        tree.reset(build_huffman_tree(decompress_encode_array(*store->encode_array())));
+    }
+}
+
+void CompressedPage::check_record_bits(uint32_t page_id, uint32_t start_bit, uint32_t end_bit) const {
+    if (start_bit > end_bit || end_bit > total_bits) {
+        throw std::runtime_error("Invalid record bits " + std::to_string(start_bit) + "/" + std::to_string(end_bit) +
+                                 " on page " + std::to_string(page_id) + " of " + std::to_string(total_bits) + " bits");
+    }
+}
+
+size_t decoded_capacity(const CompressedPage& page, uint32_t page_id, const RecordOffsets& offsets, size_t first, size_t last) {
+    if (first == last) return 0;
+    const uint32_t end_bit = last < offsets.size() ? offsets[last] : page.total_bits;
+    page.check_record_bits(page_id, offsets[first], end_bit);
+    return page.decoder->max_decoded_size(end_bit - offsets[first], last - first);
+}
+
+size_t decode_records(const CompressedPage& page, uint32_t page_id, const RecordOffsets& offsets, size_t first, size_t last,
+                      const DecodeOptions& options, char* out, uint32_t* ends) {
+    Stats::Timer timer(Stats::kDecode);
+    if (!options.use_reference && !options.verify) {
+        // Interleaved kernel: records come back to back, split by their end offsets
+        std::vector<uint32_t> bounds(offsets.data + first, offsets.data + last);
+        bounds.push_back(last < offsets.size() ? offsets[last] : page.total_bits);
+        for (size_t i = 0; i + 1 < bounds.size(); i++) {
+            page.check_record_bits(page_id, bounds[i], bounds[i + 1]);
+        }
+        return page.decoder->decode_records(page.bitstream, bounds.data(), last - first, out, ends);
+    }
+
+    size_t written = 0;
+    for (size_t i = first; i < last; i++) {
+        uint32_t start_bit = offsets[i];
+        uint32_t end_bit = (i + 1 < offsets.size()) ? offsets[i + 1] : page.total_bits; // end of the compressed buffer
+        page.check_record_bits(page_id, start_bit, end_bit);
+        std::string decompressed = options.use_reference
+            ? decode_substring(page.buffer, page.tree.get(), start_bit, end_bit)
+            : page.decoder->decode_substring(page.bitstream, start_bit, end_bit);
+        if (options.verify && decompressed != decode_substring(page.buffer, page.tree.get(), start_bit, end_bit)) {
+            throw std::runtime_error("Decoder mismatch on page " + std::to_string(page_id) + " bits " +
+                                     std::to_string(start_bit) + "/" + std::to_string(end_bit));
+        }
+        std::memcpy(out + written, decompressed.data(), decompressed.size());
+        written += decompressed.size();
+        ends[i - first] = static_cast<uint32_t>(written);
+    }
+    return written;
+}
+
+void decode_records(const CompressedPage& page, uint32_t page_id, const RecordOffsets& offsets, size_t first, size_t last,
+                    const DecodeOptions& options, DecodedRecords& records) {
+    const size_t base = records.bytes.size();
+    const size_t count = last - first;
+    records.bytes.resize(base + decoded_capacity(page, page_id, offsets, first, last));
+    records.ends.resize(records.ends.size() + count);
+    uint32_t* ends = records.ends.data() + records.ends.size() - count;
+    size_t size = decode_records(page, page_id, offsets, first, last, options, &records.bytes[base], ends);
+    for (size_t i = 0; i < count; i++) {
+        ends[i] += static_cast<uint32_t>(base);
+    }
+    records.bytes.resize(base + size);
+}
+
+void decode_uncompressed_page(column_data_dictionary_t::uncompressed_strings_t* store, DecodedRecords& records) {
+    Stats::Timer timer(Stats::kDecode);
+    // Null-terminated strings, converted and split in one pass; the
+    // terminators stay in the buffer as separators
+    Utf8Strings strings;
+    split_utf16le(store->used_character_bytes(), strings);
+    records.bytes.swap(strings.bytes);
+    records.ends.swap(strings.ends);
+    records.separator = 1;
+}
+
+void decode_page(column_data_dictionary_t::dictionary_page_t* page, uint32_t page_id, const RecordOffsets& offsets,
+                 const DecodeOptions& options, DecodedRecords& records) {
+    records.clear();
+    if(page->page_compressed()){
+        CompressedPage compressed(static_cast<column_data_dictionary_t::compressed_strings_t*>(page->string_store()), options);
+        decode_records(compressed, page_id, offsets, 0, offsets.size(), options, records);
+    } else {
+        decode_uncompressed_page(static_cast<column_data_dictionary_t::uncompressed_strings_t *>(page->string_store()), records);
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef PAGE_DECODER_H_
+#define PAGE_DECODER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "column_data_dictionary.h"
+#include "huffman.h"
+
+// Decoding of whole dictionary pages, or runs of their records, into one
+// buffer per run. Shared by DictionaryReader and the CLI's page loop.
+
+struct DecodeOptions {
+    bool use_reference = false; // decode with the bit-at-a-time tree walk
+    bool verify = false;        // decode with both and compare
+};
+
+// The record handle offsets of one page, a range of the array built by group_offsets_by_page()
+struct RecordOffsets {
+    const uint32_t* data = nullptr;
+    size_t count = 0;
+
+    size_t size() const { return count; }
+    uint32_t operator[](size_t i) const { return data[i]; }
+};
+
+// Group the bit_or_byte_offset of every record handle by page with a counting
+// sort: one pass counts the handles of each page, a second writes each offset
+// into its page's range. page_begin[p] .. page_begin[p + 1] is the range of
+// page p; handles keep their order within a page.
+std::vector<uint32_t> group_offsets_by_page(const std::pmr::vector<column_data_dictionary_t::string_record_handle_t>& handles,
+                                            size_t page_count, std::vector<size_t>& page_begin);
+
+// Huffman state of one compressed page, shared read-only by the workers decoding it
+struct CompressedPage {
+    std::string_view buffer;        // pair-swapped, as stored
+    PageBitstream bitstream;        // normalized for the table decoder
+    uint32_t total_bits;
+    std::shared_ptr<const HuffmanDecoder> decoder; // shared through DecoderCache
+    std::unique_ptr<HuffmanTree> tree; // only built for --reference and --verify
+
+    explicit CompressedPage(column_data_dictionary_t::compressed_strings_t* store, const DecodeOptions& options = DecodeOptions());
+
+    // Throw std::runtime_error unless start_bit <= end_bit <= total_bits;
+    // record offsets come from the file and size the decode buffers
+    void check_record_bits(uint32_t page_id, uint32_t start_bit, uint32_t end_bit) const;
+};
+
+// Decoded values of a run of records inside a buffer it does not own
+struct RecordsView {
+    const char* bytes = nullptr;    // start of the run
+    const uint32_t* ends = nullptr; // end offset of each value from bytes
+    size_t count = 0;
+    uint32_t separator = 0;         // bytes between consecutive values
+
+    size_t size() const { return count; }
+    std::string_view operator[](size_t i) const {
+        size_t begin = i ? ends[i - 1] + separator : 0;
+        return std::string_view(bytes + begin, ends[i] - begin);
+    }
+};
+
+// Decoded values of a run of records, kept in one buffer until they are written out
+struct DecodedRecords {
+    std::string bytes;          // values back to back
+    std::vector<uint32_t> ends; // end offset of each value in bytes
+    uint32_t separator = 0;     // bytes between consecutive values
+
+    void clear() {
+        bytes.clear();
+        ends.clear();
+        separator = 0;
+    }
+    size_t size() const { return ends.size(); }
+    std::string_view operator[](size_t i) const {
+        size_t begin = i ? ends[i - 1] + separator : 0;
+        return std::string_view(bytes.data() + begin, ends[i] - begin);
+    }
+    RecordsView view() const { return RecordsView{bytes.data(), ends.data(), ends.size(), separator}; }
+};
+
+// Upper bound of the decoded size of records [first, last) of a compressed
+// page. offsets are the bit_or_byte_offset of the page's record handles.
+// Throws std::runtime_error when the run starts after it ends or ends past the
+// page's bits.
+size_t decoded_capacity(const CompressedPage& page, uint32_t page_id, const RecordOffsets& offsets, size_t first, size_t last);
+
+// Decode records [first, last) of a compressed page back to back into out,
+// which must hold decoded_capacity() bytes; ends[i] receives the end offset of
+// record first + i in out. Returns the bytes written. Throws
+// std::runtime_error when the offsets are out of order or past the end of the
+// page's bits, or when --verify finds a mismatch.
+size_t decode_records(const CompressedPage& page, uint32_t page_id, const RecordOffsets& offsets, size_t first, size_t last,
+                      const DecodeOptions& options, char* out, uint32_t* ends);
+
+// The same, appending the records to records
+void decode_records(const CompressedPage& page, uint32_t page_id, const RecordOffsets& offsets, size_t first, size_t last,
+                    const DecodeOptions& options, DecodedRecords& records);
+
+// Split an uncompressed page into records, replacing their contents
+void decode_uncompressed_page(column_data_dictionary_t::uncompressed_strings_t* store, DecodedRecords& records);
+
+// Decode every string of a page into records, replacing their contents
+void decode_page(column_data_dictionary_t::dictionary_page_t* page, uint32_t page_id, const RecordOffsets& offsets,
+                 const DecodeOptions& options, DecodedRecords& records);
+
+#endif  // PAGE_DECODER_H_
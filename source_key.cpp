@@ -0,0 +1,34 @@
+#include "source_key.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+#include "mapped_file.h"
+
+namespace {
+
+const size_t kHashedBytes = 64 * 1024;  // from each end of the file
+
+uint64_t fnv1a(const char* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * 1099511628211ull;
+    }
+    return hash;
+}
+
+} // namespace
+
+SourceKey source_key(const std::string& path) {
+    MappedFile file;
+    if (!file.open(path)) {
+        throw std::runtime_error("Error opening file: " + path);
+    }
+    SourceKey key;
+    key.size = file.size();
+    key.mtime = static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+    const size_t head = std::min(file.size(), kHashedBytes);
+    const size_t tail = std::min(file.size() - head, kHashedBytes);
+    key.hash = fnv1a(file.data() + file.size() - tail, tail, fnv1a(file.data(), head));
+    return key;
+}
@@ -0,0 +1,25 @@
+#ifndef SOURCE_KEY_H_
+#define SOURCE_KEY_H_
+
+#include <cstdint>
+#include <string>
+
+// Identity of a dictionary file for files derived from it (ValueCache
+// sidecars, DictionaryIndex files): its size, modification time and an
+// FNV-1a hash of its first and last 64 KiB, so computing it touches two small
+// ranges of the file whatever its size.
+struct SourceKey {
+    uint64_t size = 0;
+    int64_t mtime = 0;
+    uint64_t hash = 0;
+
+    bool operator==(const SourceKey& other) const {
+        return size == other.size && mtime == other.mtime && hash == other.hash;
+    }
+    bool operator!=(const SourceKey& other) const { return !(*this == other); }
+};
+
+// Throws std::runtime_error if the file cannot be opened
+SourceKey source_key(const std::string& path);
+
+#endif  // SOURCE_KEY_H_
@@ -0,0 +1,153 @@
+#include "stats.h"
+
+#include <cstdio>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+std::atomic<bool> Stats::s_enabled{false};
+std::atomic<uint64_t> Stats::s_allocations{0};
+std::atomic<uint64_t> Stats::s_allocated_bytes{0};
+
+namespace {
+
+const char* const kPhaseNames[Stats::kPhaseCount] = {
+    "open", "parse", "decompress_encode_array", "generate_codes", "build_tree", "build_table", "decode", "output",
+};
+
+std::atomic<uint64_t> phase_nanos[Stats::kPhaseCount];
+std::atomic<uint64_t> phase_calls[Stats::kPhaseCount];
+std::atomic<uint64_t> files{0};
+std::atomic<uint64_t> file_bytes{0};
+std::atomic<uint64_t> values{0};
+std::atomic<uint64_t> decoder_cache_hits{0};
+std::atomic<uint64_t> decoder_cache_misses{0};
+std::atomic<uint64_t> value_cache_hits{0};
+std::atomic<uint64_t> value_cache_misses{0};
+std::chrono::steady_clock::time_point start_time;
+
+std::mutex pages_mutex;
+std::vector<Stats::PageStats> pages;
+
+double ratio(double a, double b) {
+    return b > 0 ? a / b : 0;
+}
+
+} // namespace
+
+void Stats::enable() {
+    start_time = std::chrono::steady_clock::now();
+    s_enabled.store(true, std::memory_order_relaxed);
+}
+
+void Stats::add_time(Phase phase, std::chrono::steady_clock::duration elapsed) {
+    phase_nanos[phase].fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(), std::memory_order_relaxed);
+    phase_calls[phase].fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::add_file(uint64_t bytes, uint64_t file_values) {
+    if (!enabled()) return;
+    files.fetch_add(1, std::memory_order_relaxed);
+    file_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    values.fetch_add(file_values, std::memory_order_relaxed);
+}
+
+void Stats::count_decoder_cache(bool hit) {
+    if (!enabled()) return;
+    (hit ? decoder_cache_hits : decoder_cache_misses).fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::count_value_cache(bool hit) {
+    if (!enabled()) return;
+    (hit ? value_cache_hits : value_cache_misses).fetch_add(1, std::memory_order_relaxed);
+}
+
+void Stats::add_page(const PageStats& page) {
+    if (!enabled()) return;
+    std::lock_guard<std::mutex> lock(pages_mutex);
+    pages.push_back(page);
+}
+
+uint64_t Stats::peak_rss() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return static_cast<uint64_t>(usage.ru_maxrss);        // bytes
+#else
+    return static_cast<uint64_t>(usage.ru_maxrss) * 1024; // kilobytes
+#endif
+#endif
+}
+
+void Stats::write_json(std::ostream& out) {
+    const double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    std::lock_guard<std::mutex> lock(pages_mutex);
+
+    uint64_t compressed_pages = 0, strings = 0, store_bytes = 0, bits = 0, decoded_bytes = 0;
+    for (const PageStats& page : pages) {
+        compressed_pages += page.compressed;
+        strings += page.strings;
+        store_bytes += page.store_bytes;
+        bits += page.bits;
+        decoded_bytes += page.decoded_bytes;
+    }
+
+    out << "{\n  \"version\": 1,\n  \"wall_seconds\": " << wall << ",\n  \"phases\": {";
+    for (int p = 0; p < kPhaseCount; p++) {
+        out << (p ? "," : "") << "\n    \"" << kPhaseNames[p] << "\": {\"seconds\": "
+            << phase_nanos[p].load() / 1e9 << ", \"calls\": " << phase_calls[p].load() << "}";
+    }
+    out << "\n  },\n  \"counters\": {\"files\": " << files.load() << ", \"file_bytes\": " << file_bytes.load()
+        << ", \"values\": " << values.load() << ", \"pages\": " << pages.size()
+        << ", \"compressed_pages\": " << compressed_pages << ", \"page_strings\": " << strings
+        << ", \"store_bytes\": " << store_bytes << ", \"compressed_bits\": " << bits
+        << ", \"decoded_bytes\": " << decoded_bytes << ", \"decoder_cache_hits\": " << decoder_cache_hits.load()
+        << ", \"decoder_cache_misses\": " << decoder_cache_misses.load()
+        << ", \"value_cache_hits\": " << value_cache_hits.load() << ", \"value_cache_misses\": " << value_cache_misses.load() << "},\n";
+    out << "  \"memory\": {\"peak_rss_bytes\": " << peak_rss() << ", \"allocations\": " << s_allocations.load()
+        << ", \"allocated_bytes\": " << s_allocated_bytes.load() << "},\n  \"pages\": [";
+    for (size_t i = 0; i < pages.size(); i++) {
+        const PageStats& page = pages[i];
+        out << (i ? "," : "") << "\n    {\"file\": " << json_string(page.file) << ", \"page\": " << page.page_id
+            << ", \"compressed\": " << (page.compressed ? "true" : "false") << ", \"strings\": " << page.strings
+            << ", \"store_bytes\": " << page.store_bytes << ", \"bits\": " << page.bits
+            << ", \"decoded_bytes\": " << page.decoded_bytes << ", \"characters\": " << page.characters
+            << ", \"compression_ratio\": " << ratio(page.decoded_bytes, page.store_bytes);
+        if (page.compressed) {
+            out << ", \"average_code_length\": " << ratio(page.bits, page.characters)
+                << ", \"symbols\": " << page.symbols << ", \"max_code_length\": " << page.max_code_length;
+        }
+        out << "}";
+    }
+    out << (pages.empty() ? "]\n}\n" : "\n  ]\n}\n");
+}
+
+std::string json_string(const std::string& s) {
+    std::ostringstream out;
+    out << '"';
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+    return out.str();
+}
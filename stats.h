@@ -0,0 +1,98 @@
+#ifndef STATS_H_
+#define STATS_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Process-wide timers and counters for --stats.
+//
+// Everything is off until enable() is called. While disabled every hook is a
+// single relaxed load and branch, so the instrumented hot paths cost nothing
+// measurable; when enabled, timers and counters are relaxed atomics and can be
+// hit from any worker thread. Phase times are summed over threads, so with
+// --threads they measure CPU time spent in the phase rather than wall time.
+class Stats {
+public:
+    enum Phase {
+        kOpen,                  // opening or mapping the file
+        kParse,                 // column_data_dictionary_t construction
+        kDecompressEncodeArray, // decompress_encode_array()
+        kGenerateCodes,         // canonical_codes(), also inside generate_codes() and build_huffman_tree()
+        kBuildTree,             // build_huffman_tree()
+        kBuildTable,            // HuffmanDecoder construction, on DecoderCache misses
+        kDecode,                // decoding compressed records and splitting UTF-16 pages
+        kOutput,                // framing values into the writer and flushing it
+        kPhaseCount
+    };
+
+    // Statistics of one decoded page of a string dictionary
+    struct PageStats {
+        std::string file;
+        uint32_t page_id = 0;
+        bool compressed = false;
+        uint64_t strings = 0;
+        uint64_t store_bytes = 0;   // compressed buffer, or used UTF-16 bytes
+        uint64_t bits = 0;          // store_total_bits of a compressed page
+        uint64_t decoded_bytes = 0; // UTF-8 bytes of the values
+        uint64_t characters = 0;    // code points of the values
+        uint32_t symbols = 0;       // symbols with a Huffman code
+        uint32_t max_code_length = 0;
+    };
+
+    // Times the enclosing scope into a phase
+    class Timer {
+    public:
+        explicit Timer(Phase phase) : m_phase(phase), m_running(enabled()) {
+            if (m_running) m_start = std::chrono::steady_clock::now();
+        }
+        ~Timer() { stop(); }
+
+        // End the measurement before the end of the scope
+        void stop() {
+            if (!m_running) return;
+            m_running = false;
+            add_time(m_phase, std::chrono::steady_clock::now() - m_start);
+        }
+
+    private:
+        Phase m_phase;
+        bool m_running;
+        std::chrono::steady_clock::time_point m_start;
+    };
+
+    static bool enabled() { return s_enabled.load(std::memory_order_relaxed); }
+    static void enable();
+
+    static void add_time(Phase phase, std::chrono::steady_clock::duration elapsed);
+    static void add_file(uint64_t bytes, uint64_t values);
+    static void add_page(const PageStats& page);
+    static void count_decoder_cache(bool hit);
+    static void count_value_cache(bool hit);
+    static void count_allocation(size_t bytes) {
+        if (!enabled()) return;
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+        s_allocated_bytes.fetch_add(bytes, std::memory_order_relaxed);
+    }
+
+    // Peak resident set size of the process in bytes, 0 where unknown
+    static uint64_t peak_rss();
+
+    // Report of everything collected since enable(), as one JSON object
+    static void write_json(std::ostream& out);
+
+private:
+    static std::atomic<bool> s_enabled;
+    static std::atomic<uint64_t> s_allocations;
+    static std::atomic<uint64_t> s_allocated_bytes;
+};
+
+// `s` as a quoted JSON string
+std::string json_string(const std::string& s);
+
+#endif  // STATS_H_
@@ -0,0 +1,72 @@
+#include "string_filter.h"
+
+#include <algorithm>
+
+#include "utf16.h"
+
+bool StringPredicate::matches(std::string_view decoded) const {
+    switch (kind) {
+    case MatchKind::kEquals:
+        return decoded == value;
+    case MatchKind::kPrefix:
+        return decoded.substr(0, value.size()) == value;
+    case MatchKind::kContains:
+        return decoded.find(value) != std::string_view::npos;
+    }
+    return false;
+}
+
+CompressedMatcher::CompressedMatcher(const StringPredicate& predicate, const std::vector<uint8_t>& lengths)
+    : m_kind(predicate.kind) {
+    // Symbol-presence bitmap of the page
+    uint64_t present[4] = {0, 0, 0, 0};
+    m_min_code_length = HuffmanDecoder::kMaxCodeLength + 1;
+    for (uint32_t symbol = 0; symbol < 256; symbol++) {
+        if (lengths[symbol] == 0) continue;
+        present[symbol >> 6] |= uint64_t(1) << (symbol & 63);
+        m_min_code_length = std::min<uint32_t>(m_min_code_length, lengths[symbol]);
+    }
+
+    // Compressed pages hold ISO-8859-1 symbols only
+    std::vector<uint8_t> symbols;
+    for (size_t i = 0; i < predicate.value.size();) {
+        uint32_t code_point = next_code_point(predicate.value, i);
+        if (code_point > 0xFF || !(present[code_point >> 6] & (uint64_t(1) << (code_point & 63)))) {
+            m_page_can_match = false;
+            return;
+        }
+        symbols.push_back(static_cast<uint8_t>(code_point));
+    }
+    if (!exact()) return;
+
+    const CanonicalCodes codes = canonical_codes(lengths);
+    Chunk chunk{0, 0};
+    for (uint8_t symbol : symbols) {
+        const uint32_t length = codes.length[symbol];
+        if (chunk.count + length > 56) {
+            m_chunks.push_back(chunk);
+            chunk = Chunk{0, 0};
+        }
+        chunk.bits = (chunk.bits << length) | codes.code[symbol];
+        chunk.count += length;
+        m_total_bits += length;
+    }
+    if (chunk.count) m_chunks.push_back(chunk);
+}
+
+bool CompressedMatcher::record_matches(const PageBitstream& bitstream, uint32_t start_bit, uint32_t end_bit) const {
+    if (end_bit < start_bit || end_bit - start_bit < m_total_bits) return false;
+    uint32_t pos = start_bit;
+    for (const Chunk& chunk : m_chunks) {
+        if ((bitstream.peek(pos) >> (64 - chunk.count)) != chunk.bits) return false;
+        pos += chunk.count;
+    }
+    // Equal when no further symbol fits in the record
+    return m_kind == MatchKind::kPrefix || end_bit - pos < m_min_code_length;
+}
+
+bool uncompressed_page_can_match(const StringPredicate& predicate, std::string_view utf16) {
+    std::string pattern;
+    utf8_to_utf16le(predicate.value, pattern);
+    return utf16.find(pattern) != std::string_view::npos;
+}
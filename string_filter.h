@@ -0,0 +1,71 @@
+#ifndef STRING_FILTER_H_
+#define STRING_FILTER_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "huffman.h"
+
+// Predicates over dictionary values, evaluated as far as possible without
+// decoding them; see DictionaryReader::filter().
+//
+// A compressed page can only hold characters that have a code in its
+// encode_array, so a page missing any character of the value is skipped
+// whole. Within a page, a record starts with the value exactly when its bits
+// start with the value's canonical codes, so prefix and equality tests
+// compare bit strings and only matching records are decoded. Substring tests
+// decode the records of the pages that pass the character check. An
+// uncompressed page is skipped when the value's UTF-16LE bytes occur nowhere
+// in it.
+
+enum class MatchKind {
+    kEquals,
+    kPrefix,
+    kContains,
+};
+
+struct StringPredicate {
+    MatchKind kind = MatchKind::kEquals;
+    std::string value;  // UTF-8
+
+    // Test a decoded value
+    bool matches(std::string_view decoded) const;
+};
+
+// A predicate compiled against the Huffman code of one compressed page
+class CompressedMatcher {
+public:
+    // lengths is the page's full 256-entry code length array, see decompress_encode_array()
+    CompressedMatcher(const StringPredicate& predicate, const std::vector<uint8_t>& lengths);
+
+    // False when a character of the value has no code in the page
+    bool page_can_match() const { return m_page_can_match; }
+
+    // Whether record_matches() decides the predicate on its own; substring
+    // tests need the decoded value
+    bool exact() const { return m_kind != MatchKind::kContains; }
+
+    // Prefix or equality test of the record [start_bit, end_bit) against the
+    // value's code bits. Only valid when page_can_match() and exact().
+    bool record_matches(const PageBitstream& bitstream, uint32_t start_bit, uint32_t end_bit) const;
+
+private:
+    // Up to 56 code bits, right-aligned
+    struct Chunk {
+        uint64_t bits;
+        uint32_t count;
+    };
+
+    MatchKind m_kind;
+    bool m_page_can_match = true;
+    uint32_t m_min_code_length = 0;
+    uint64_t m_total_bits = 0;
+    std::vector<Chunk> m_chunks;
+};
+
+// False when an uncompressed page's used UTF-16LE bytes cannot hold a match
+bool uncompressed_page_can_match(const StringPredicate& predicate, std::string_view utf16);
+
+#endif  // STRING_FILTER_H_
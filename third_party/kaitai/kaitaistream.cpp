@@ -36,16 +36,48 @@
 #include <vector>
 #include <stdexcept>
 
-kaitai::kstream::kstream(std::istream *io) {
+kaitai::kstream::kstream(std::istream *io) : m_mem_data(0), m_mem_size(0), m_mem_buf(0, 0), m_io_mem(&m_mem_buf) {
     m_io = io;
     init();
 }
 
-kaitai::kstream::kstream(const std::string &data) : m_io_str(data) {
+kaitai::kstream::kstream(const std::string &data) : m_io_str(data), m_mem_data(0), m_mem_size(0), m_mem_buf(0, 0), m_io_mem(&m_mem_buf) {
     m_io = &m_io_str;
     init();
 }
 
+kaitai::kstream::kstream(const char *data, std::size_t size) : m_mem_data(data), m_mem_size(size), m_mem_buf(data, size), m_io_mem(&m_mem_buf) {
+    m_io = &m_io_mem;
+    init();
+}
+
+kaitai::kstream::memory_streambuf::memory_streambuf(const char *data, std::size_t size) {
+    char *p = const_cast<char *>(data);
+    setg(p, p, p + size);
+}
+
+std::streambuf::pos_type kaitai::kstream::memory_streambuf::seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) {
+    if (!(which & std::ios_base::in))
+        return pos_type(off_type(-1));
+    off_type base;
+    if (dir == std::ios_base::beg) {
+        base = 0;
+    } else if (dir == std::ios_base::cur) {
+        base = gptr() - eback();
+    } else {
+        base = egptr() - eback();
+    }
+    off_type target = base + off;
+    if (target < 0 || target > egptr() - eback())
+        return pos_type(off_type(-1));
+    setg(eback(), eback() + target, egptr());
+    return pos_type(target);
+}
+
+std::streambuf::pos_type kaitai::kstream::memory_streambuf::seekpos(pos_type pos, std::ios_base::openmode which) {
+    return seekoff(off_type(pos), std::ios_base::beg, which);
+}
+
 void kaitai::kstream::init() {
     exceptions_enable();
     align_to_byte();
@@ -403,6 +435,43 @@ std::string kaitai::kstream::read_bytes(std::streamsize len) {
     return std::string(result.begin(), result.end());
 }
 
+std::string_view kaitai::kstream::read_bytes_view(std::streamsize len, std::string &storage) {
+    if (len < 0) {
+        throw std::runtime_error("read_bytes_view: requested a negative amount");
+    }
+
+    if (!is_memory_backed()) {
+        storage = read_bytes(len);
+        return std::string_view(storage);
+    }
+
+    uint64_t p = pos();
+    if (static_cast<uint64_t>(len) > m_mem_size - p) {
+        throw std::runtime_error("read_bytes_view: requested more bytes than available");
+    }
+    seek(p + len);
+    return std::string_view(m_mem_data + p, len);
+}
+
+std::string_view kaitai::kstream::read_bytes_view(std::streamsize len, std::pmr::memory_resource* storage) {
+    if (len < 0) {
+        throw std::runtime_error("read_bytes_view: requested a negative amount");
+    }
+
+    if (!is_memory_backed()) {
+        char* bytes = static_cast<char*>(storage->allocate(len, 1));
+        m_io->read(bytes, len);
+        return std::string_view(bytes, len);
+    }
+
+    uint64_t p = pos();
+    if (static_cast<uint64_t>(len) > m_mem_size - p) {
+        throw std::runtime_error("read_bytes_view: requested more bytes than available");
+    }
+    seek(p + len);
+    return std::string_view(m_mem_data + p, len);
+}
+
 std::string kaitai::kstream::read_bytes_full() {
     std::iostream::pos_type p1 = m_io->tellg();
     m_io->seekg(0, std::ios::end);
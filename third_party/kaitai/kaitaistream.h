@@ -5,7 +5,10 @@
 #define KAITAI_STRUCT_VERSION 10000L
 
 #include <istream>
+#include <memory_resource>
 #include <sstream>
+#include <streambuf>
+#include <string_view>
 #include <stdint.h>
 #include <sys/types.h>
 #include <limits>
@@ -46,8 +49,23 @@ public:
      */
     kstream(const std::string& data);
 
+    /**
+     * Constructs new Kaitai Stream object over an externally owned memory
+     * region (e.g. a memory-mapped file) without copying it. The region must
+     * outlive the stream and everything parsed from it.
+     * \param data start of the memory region
+     * \param size size of the memory region in bytes
+     */
+    kstream(const char* data, std::size_t size);
+
     void close();
 
+    /**
+     * Check if the stream reads from a memory region given at construction,
+     * i.e. if read_bytes_view() returns views into that region.
+     */
+    bool is_memory_backed() const { return m_mem_data != 0; }
+
     /** @name Stream positioning */
     //@{
     /**
@@ -161,6 +179,20 @@ public:
     //@{
 
     std::string read_bytes(std::streamsize len);
+
+    /**
+     * Reads `len` bytes without copying them when the stream is memory backed:
+     * the returned view points into the underlying memory region. Other
+     * streams read the bytes into `storage` and return a view of it.
+     */
+    std::string_view read_bytes_view(std::streamsize len, std::string& storage);
+
+    /**
+     * Like read_bytes_view(), but other streams read the bytes into a buffer
+     * allocated from `storage`, which owns it.
+     */
+    std::string_view read_bytes_view(std::streamsize len, std::pmr::memory_resource* storage);
+
     std::string read_bytes_full();
     std::string read_bytes_term(char term, bool include, bool consume, bool eos_error);
     std::string ensure_fixed_contents(std::string expected);
@@ -330,8 +362,22 @@ public:
     static uint8_t byte_array_max(const std::string val);
 
 private:
+    /** Read-only std::streambuf over a memory region, used by the memory-backed constructor */
+    class memory_streambuf : public std::streambuf {
+    public:
+        memory_streambuf(const char* data, std::size_t size);
+
+    protected:
+        pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which);
+        pos_type seekpos(pos_type pos, std::ios_base::openmode which);
+    };
+
     std::istream* m_io;
     std::istringstream m_io_str;
+    const char* m_mem_data;
+    uint64_t m_mem_size;
+    memory_streambuf m_mem_buf;
+    std::istream m_io_mem;
     int m_bits_left;
     uint64_t m_bits;
 
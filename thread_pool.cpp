@@ -0,0 +1,101 @@
+#include "thread_pool.h"
+
+#include <algorithm>
+
+namespace {
+
+// Pool and queue index of the worker running on this thread, null outside any pool
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_index = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(size_t num_threads) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < num_threads; i++) {
+        m_queues.emplace_back(new Queue);
+    }
+    for (size_t i = 0; i < num_threads; i++) {
+        m_threads.emplace_back(&ThreadPool::worker_loop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void ThreadPool::push(std::function<void()> task) {
+    const bool local = current_pool == this;
+    size_t index = local ? current_index : m_next_queue++ % m_queues.size();
+    {
+        Queue& queue = *m_queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        (local ? queue.local : queue.external).push_back(std::move(task));
+    }
+    {
+        // Taking the wake mutex orders the increment against a worker's wait predicate
+        std::lock_guard<std::mutex> lock(m_wake_mutex);
+        m_pending++;
+    }
+    m_wake.notify_one();
+}
+
+bool ThreadPool::pop(size_t index, std::function<void()>& task) {
+    // Own queue first: the newest task this worker submitted, else the oldest
+    // one submitted from outside
+    {
+        Queue& own = *m_queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.local.empty()) {
+            task = std::move(own.local.back());
+            own.local.pop_back();
+            return true;
+        }
+        if (!own.external.empty()) {
+            task = std::move(own.external.front());
+            own.external.pop_front();
+            return true;
+        }
+    }
+    // Then steal the oldest task of another worker
+    for (size_t i = 1; i < m_queues.size(); i++) {
+        Queue& victim = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        for (auto* tasks : {&victim.external, &victim.local}) {
+            if (!tasks->empty()) {
+                task = std::move(tasks->front());
+                tasks->pop_front();
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+void ThreadPool::worker_loop(size_t index) {
+    current_pool = this;
+    current_index = index;
+
+    std::function<void()> task;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_wake_mutex);
+            m_wake.wait(lock, [this] { return m_stop || m_pending > 0; });
+            if (m_pending == 0 && m_stop) return;
+        }
+        if (pop(index, task)) {
+            m_pending--;
+            task();
+            task = nullptr;
+        }
+    }
+}
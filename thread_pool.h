@@ -0,0 +1,65 @@
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fixed-size work-stealing thread pool.
+//
+// Every worker owns two deques. Tasks submitted from a worker go to the back
+// of its own local deque and are popped LIFO. Tasks submitted from outside the
+// pool are spread round-robin over the external deques and popped FIFO, so
+// they start in submission order and a caller can submit its longest tasks
+// first. An idle worker steals the oldest task of the other workers, external
+// ones first, so a few long tasks never leave the remaining workers without
+// work.
+class ThreadPool {
+public:
+    // num_threads == 0 uses std::thread::hardware_concurrency()
+    explicit ThreadPool(size_t num_threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return m_threads.size(); }
+
+    template <typename F>
+    std::future<typename std::invoke_result<F>::type> submit(F&& f) {
+        using R = typename std::invoke_result<F>::type;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> result = task->get_future();
+        push([task]() { (*task)(); });
+        return result;
+    }
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> local;    // submitted by this worker
+        std::deque<std::function<void()>> external; // submitted from outside the pool
+    };
+
+    void push(std::function<void()> task);
+    bool pop(size_t index, std::function<void()>& task);
+    void worker_loop(size_t index);
+
+    std::vector<std::unique_ptr<Queue>> m_queues;
+    std::vector<std::thread> m_threads;
+    std::mutex m_wake_mutex;
+    std::condition_variable m_wake;
+    std::atomic<size_t> m_pending{0};
+    std::atomic<size_t> m_next_queue{0};
+    bool m_stop = false;
+};
+
+#endif  // THREAD_POOL_H_
@@ -0,0 +1,177 @@
+#include "utf16.h"
+
+#if defined(__GNUC__) && defined(__SSE2__) && (defined(__x86_64__) || defined(__i386__))
+#define UTF16_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+inline uint32_t load_unit(const char* p) {
+    return static_cast<uint8_t>(p[0]) | (static_cast<uint32_t>(static_cast<uint8_t>(p[1])) << 8);
+}
+
+// Convert the code point starting at code unit i, returns the code units consumed
+inline size_t convert_one(const char* utf16, size_t i, size_t units, char*& p, const char* out,
+                          std::vector<uint32_t>* nul_offsets) {
+    uint32_t cp = load_unit(utf16 + 2 * i);
+    if (cp < 0x80) {
+        if (cp == 0 && nul_offsets) nul_offsets->push_back(static_cast<uint32_t>(p - out));
+        *p++ = static_cast<char>(cp);
+        return 1;
+    }
+    if (cp < 0x800) {
+        *p++ = static_cast<char>(0xC0 | (cp >> 6));
+        *p++ = static_cast<char>(0x80 | (cp & 0x3F));
+        return 1;
+    }
+    if (cp >= 0xD800 && cp <= 0xDFFF) {
+        uint32_t low = (cp <= 0xDBFF && i + 1 < units) ? load_unit(utf16 + 2 * (i + 1)) : 0;
+        if (low >= 0xDC00 && low <= 0xDFFF) {
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+            *p++ = static_cast<char>(0xF0 | (cp >> 18));
+            *p++ = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            *p++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            *p++ = static_cast<char>(0x80 | (cp & 0x3F));
+            return 2;
+        }
+        cp = 0xFFFD;
+    }
+    *p++ = static_cast<char>(0xE0 | (cp >> 12));
+    *p++ = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    *p++ = static_cast<char>(0x80 | (cp & 0x3F));
+    return 1;
+}
+
+#ifdef UTF16_X86_SIMD
+
+inline void record_nuls(uint32_t mask, uint32_t base, std::vector<uint32_t>* nul_offsets) {
+    while (mask) {
+        nul_offsets->push_back(base + __builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+}
+
+size_t convert_sse2(const char* utf16, size_t units, char* out, std::vector<uint32_t>* nul_offsets) {
+    const __m128i non_ascii = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    char* p = out;
+    size_t i = 0;
+    while (i + 8 <= units) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(utf16 + 2 * i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, non_ascii), zero)) == 0xFFFF) {
+            // Eight ASCII code units (NUL included) narrow to eight bytes
+            __m128i bytes = _mm_packus_epi16(v, v);
+            _mm_storel_epi64(reinterpret_cast<__m128i*>(p), bytes);
+            if (nul_offsets) {
+                record_nuls(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, zero)) & 0xFF, static_cast<uint32_t>(p - out), nul_offsets);
+            }
+            p += 8;
+            i += 8;
+            continue;
+        }
+        for (size_t block_end = i + 8; i < block_end;) {
+            i += convert_one(utf16, i, units, p, out, nul_offsets);
+        }
+    }
+    while (i < units) {
+        i += convert_one(utf16, i, units, p, out, nul_offsets);
+    }
+    return p - out;
+}
+
+__attribute__((target("avx2")))
+size_t convert_avx2(const char* utf16, size_t units, char* out, std::vector<uint32_t>* nul_offsets) {
+    const __m256i non_ascii = _mm256_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i zero = _mm_setzero_si128();
+    char* p = out;
+    size_t i = 0;
+    while (i + 16 <= units) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(utf16 + 2 * i));
+        if (_mm256_testz_si256(v, non_ascii)) {
+            // packus narrows within each 128-bit lane, the permute brings the
+            // two lanes' bytes together in the low half
+            __m128i bytes = _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packus_epi16(v, v), 0xD8));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(p), bytes);
+            if (nul_offsets) {
+                record_nuls(_mm_movemask_epi8(_mm_cmpeq_epi8(bytes, zero)), static_cast<uint32_t>(p - out), nul_offsets);
+            }
+            p += 16;
+            i += 16;
+            continue;
+        }
+        for (size_t block_end = i + 16; i < block_end;) {
+            i += convert_one(utf16, i, units, p, out, nul_offsets);
+        }
+    }
+    while (i < units) {
+        i += convert_one(utf16, i, units, p, out, nul_offsets);
+    }
+    return p - out;
+}
+
+#endif
+
+} // namespace
+
+size_t utf16le_to_utf8(const char* utf16, size_t units, char* out, std::vector<uint32_t>* nul_offsets) {
+#ifdef UTF16_X86_SIMD
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2 ? convert_avx2(utf16, units, out, nul_offsets) : convert_sse2(utf16, units, out, nul_offsets);
+#else
+    char* p = out;
+    for (size_t i = 0; i < units;) {
+        i += convert_one(utf16, i, units, p, out, nul_offsets);
+    }
+    return p - out;
+#endif
+}
+
+void split_utf16le(std::string_view utf16, Utf8Strings& strings) {
+    const size_t units = utf16.size() / 2;
+    strings.ends.clear();
+    strings.bytes.resize(utf8_max_size(units));
+    size_t size = utf16le_to_utf8(utf16.data(), units, &strings.bytes[0], &strings.ends);
+    if (size > (strings.ends.empty() ? 0 : strings.ends.back() + 1)) {
+        strings.bytes[size] = '\0';
+        strings.ends.push_back(static_cast<uint32_t>(size++));
+    }
+    strings.bytes.resize(size);
+}
+
+uint32_t next_code_point(std::string_view utf8, size_t& i) {
+    const uint8_t lead = static_cast<uint8_t>(utf8[i++]);
+    if (lead < 0x80) return lead;
+    size_t extra = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+    if (extra == 0 || lead > 0xF4 || i + extra > utf8.size()) return 0xFFFD;
+    uint32_t cp = lead & (0x3F >> extra);
+    for (size_t k = 0; k < extra; k++) {
+        uint8_t next = static_cast<uint8_t>(utf8[i + k]);
+        if ((next & 0xC0) != 0x80) return 0xFFFD;
+        cp = (cp << 6) | (next & 0x3F);
+    }
+    // Overlong forms, surrogates and values past U+10FFFF
+    static const uint32_t min_cp[] = {0, 0x80, 0x800, 0x10000};
+    if (cp < min_cp[extra] || (cp >= 0xD800 && cp <= 0xDFFF) || cp > 0x10FFFF) return 0xFFFD;
+    i += extra;
+    return cp;
+}
+
+size_t utf8_to_utf16le(std::string_view utf8, std::string& out) {
+    size_t units = 0;
+    auto put_unit = [&](uint32_t unit) {
+        out.push_back(static_cast<char>(unit & 0xFF));
+        out.push_back(static_cast<char>(unit >> 8));
+        units++;
+    };
+    for (size_t i = 0; i < utf8.size();) {
+        uint32_t cp = next_code_point(utf8, i);
+        if (cp >= 0x10000) {
+            put_unit(0xD800 + ((cp - 0x10000) >> 10));
+            put_unit(0xDC00 + ((cp - 0x10000) & 0x3FF));
+        } else {
+            put_unit(cp);
+        }
+    }
+    return units;
+}
@@ -0,0 +1,48 @@
+#ifndef UTF16_H_
+#define UTF16_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Upper bound of UTF-8 bytes for `units` UTF-16 code units, including the
+// slack the vector paths need for their wide stores
+inline size_t utf8_max_size(size_t units) { return units * 3 + 16; }
+
+// Transcode `units` UTF-16LE code units to UTF-8 in one pass. NUL code units
+// are written as NUL bytes and, when nul_offsets is given, their offsets in
+// `out` are appended to it, so terminators are found while converting.
+// Unpaired surrogates become U+FFFD. `out` must hold utf8_max_size(units)
+// bytes. Returns the number of bytes written.
+//
+// Runs of ASCII are converted 16 (AVX2) or 8 (SSE2) code units at a time; the
+// AVX2 path is picked at run time, other targets use the scalar loop.
+size_t utf16le_to_utf8(const char* utf16, size_t units, char* out, std::vector<uint32_t>* nul_offsets = nullptr);
+
+// NUL-terminated UTF-16LE strings converted to one contiguous UTF-8 buffer
+struct Utf8Strings {
+    std::string bytes;          // every string followed by a NUL
+    std::vector<uint32_t> ends; // offset of the NUL ending each string
+
+    size_t size() const { return ends.size(); }
+    std::string_view operator[](size_t i) const {
+        size_t begin = i ? ends[i - 1] + 1 : 0;
+        return std::string_view(bytes.data() + begin, ends[i] - begin);
+    }
+};
+
+// Split a UTF-16LE buffer of NUL-terminated strings. A trailing unterminated
+// string is kept when it is not empty, like std::getline on '\0' would.
+void split_utf16le(std::string_view utf16, Utf8Strings& strings);
+
+// Decode the code point of a UTF-8 string starting at byte i and advance i
+// past it. Malformed or truncated sequences decode to U+FFFD one byte at a time.
+uint32_t next_code_point(std::string_view utf8, size_t& i);
+
+// Append a UTF-8 string to `out` as UTF-16LE, code points above U+FFFF as
+// surrogate pairs. Returns the number of code units appended.
+size_t utf8_to_utf16le(std::string_view utf8, std::string& out);
+
+#endif  // UTF16_H_
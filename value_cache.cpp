@@ -0,0 +1,196 @@
+#include "value_cache.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <vector>
+
+#include "dictionary_reader.h"
+#include "source_key.h"
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char kMagic[8] = {'V', 'D', 'C', 'A', 'C', 'H', 'E', '\0'};
+const uint32_t kVersion = 1;
+const uint32_t kByteOrderMark = 0x01020304;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t kind;
+    uint32_t reserved;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t source_hash;
+    uint64_t count;
+    uint64_t data_bytes;  // string bytes or count * element size
+};
+static_assert(sizeof(CacheHeader) == 64, "sidecar header must stay 64 bytes");
+
+size_t element_size(ValueCache::Kind kind) {
+    return kind == ValueCache::Kind::kInt32 ? 4 : 8;
+}
+
+// Create an empty file next to the sidecar under a name no other builder uses
+std::string create_temporary(const std::string& sidecar) {
+    std::string name = sidecar + ".XXXXXX";
+#ifdef _WIN32
+    if (_mktemp_s(name.data(), name.size() + 1) != 0 || !std::ofstream(name, std::ios::binary)) {
+        throw std::runtime_error("Error creating file: " + name);
+    }
+#else
+    const int fd = mkstemp(name.data());
+    if (fd < 0) {
+        throw std::runtime_error("Error creating file: " + name);
+    }
+    close(fd);
+#endif
+    return name;
+}
+
+} // namespace
+
+std::string ValueCache::sidecar_path(const std::string& dictionary_path, const std::string& cache_dir) {
+    std::filesystem::path path(dictionary_path);
+    std::filesystem::path dir = cache_dir.empty() ? path.parent_path() : std::filesystem::path(cache_dir);
+    return (dir / (path.filename().string() + ".vdcache")).string();
+}
+
+void ValueCache::build(const std::string& dictionary_path, const std::string& sidecar) {
+    const SourceKey key = source_key(dictionary_path);
+    DictionaryReader reader(dictionary_path);
+
+    CacheHeader header;
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kVersion;
+    header.byte_order = kByteOrderMark;
+    header.reserved = 0;
+    header.source_size = key.size;
+    header.source_mtime = key.mtime;
+    header.source_hash = key.hash;
+    header.count = reader.size();
+
+    std::string bytes;
+    std::vector<uint64_t> offsets;
+    const char* values = nullptr;
+    if (reader.is_string()) {
+        header.kind = static_cast<uint32_t>(Kind::kStrings);
+        offsets.reserve(reader.size() + 1);
+        offsets.push_back(0);
+        reader.for_each([&](uint64_t, std::string_view value) {
+            bytes.append(value.data(), value.size());
+            offsets.push_back(bytes.size());
+        });
+        header.count = offsets.size() - 1;
+        header.data_bytes = bytes.size();
+        values = bytes.data();
+    } else {
+        auto number_data = static_cast<column_data_dictionary_t::number_data_t*>(reader.dictionary().data());
+        auto vector_info = number_data->vector_of_vectors_info();
+        if (vector_info->is_int32()) {
+            header.kind = static_cast<uint32_t>(Kind::kInt32);
+            values = reinterpret_cast<const char*>(vector_info->values_int32()->data());
+        } else if (vector_info->is_int64()) {
+            header.kind = static_cast<uint32_t>(Kind::kInt64);
+            values = reinterpret_cast<const char*>(vector_info->values_int64()->data());
+        } else {
+            header.kind = static_cast<uint32_t>(Kind::kFloat64);
+            values = reinterpret_cast<const char*>(vector_info->values_float64()->data());
+        }
+        header.data_bytes = header.count * element_size(static_cast<Kind>(header.kind));
+    }
+
+    // Written under a temporary name of its own, so a reader never maps a
+    // partial sidecar and concurrent builders never write the same file
+    const std::string temporary = create_temporary(sidecar);
+    try {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error("Error opening file: " + temporary);
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+        out.write(values, header.data_bytes);
+        out.flush();
+        if (!out) {
+            throw std::runtime_error("Error writing file: " + temporary);
+        }
+        out.close();
+
+        // Another builder may have renamed its sidecar into place meanwhile,
+        // or may hold it open where that blocks a rename. Either way its file
+        // is as good as ours, so losing the race counts as a hit.
+        ValueCache winner;
+        if (winner.open(dictionary_path, sidecar)) {
+            std::filesystem::remove(temporary);
+            return;
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, sidecar, error);
+        if (error) {
+            if (!winner.open(dictionary_path, sidecar)) {
+                throw std::filesystem::filesystem_error("Error renaming file", temporary, sidecar, error);
+            }
+            std::filesystem::remove(temporary);
+        }
+    } catch (...) {
+        std::error_code ignored;
+        std::filesystem::remove(temporary, ignored);
+        throw;
+    }
+}
+
+bool ValueCache::open(const std::string& dictionary_path, const std::string& sidecar) {
+    m_file.close();
+    m_count = 0;
+    m_data_bytes = 0;
+    if (!m_file.open(sidecar) || m_file.size() < sizeof(CacheHeader)) {
+        m_file.close();
+        return false;
+    }
+    CacheHeader header;
+    std::memcpy(&header, m_file.data(), sizeof(header));
+    const SourceKey key = source_key(dictionary_path);
+    bool valid = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion &&
+                 header.byte_order == kByteOrderMark && header.kind <= static_cast<uint32_t>(Kind::kFloat64) &&
+                 header.source_size == key.size && header.source_mtime == key.mtime && header.source_hash == key.hash;
+
+    const uint64_t available = m_file.size() - sizeof(CacheHeader);
+    if (valid && header.kind == static_cast<uint32_t>(Kind::kStrings)) {
+        // build() writes ascending offsets; only their number is checked here
+        // so opening stays O(1), and operator[] checks the ones it reads
+        const uint64_t* offsets = reinterpret_cast<const uint64_t*>(m_file.data() + sizeof(CacheHeader));
+        valid = header.count < available / sizeof(uint64_t) &&
+                available - (header.count + 1) * sizeof(uint64_t) == header.data_bytes;
+        if (valid) {
+            m_offsets = offsets;
+            m_data = reinterpret_cast<const char*>(offsets + header.count + 1);
+        }
+    } else if (valid) {
+        valid = header.data_bytes == available &&
+                header.count == header.data_bytes / element_size(static_cast<Kind>(header.kind));
+        m_offsets = nullptr;
+        m_data = m_file.data() + sizeof(CacheHeader);
+    }
+    if (!valid) {
+        m_file.close();
+        return false;
+    }
+    m_kind = static_cast<Kind>(header.kind);
+    m_count = header.count;
+    m_data_bytes = header.data_bytes;
+    return true;
+}
+
+void ValueCache::damaged() {
+    throw std::runtime_error("Damaged cache file: value offsets out of range");
+}
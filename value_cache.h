@@ -0,0 +1,72 @@
+#ifndef VALUE_CACHE_H_
+#define VALUE_CACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "mapped_file.h"
+
+// Decoded values of a dictionary in a sidecar file that is mapped and used in
+// place, so an unchanged dictionary is parsed and decoded only once.
+//
+// The sidecar is a 64-byte header followed by either count + 1 u8 end
+// offsets and the UTF-8 values back to back, or the count numbers in their
+// stored type. Everything is in host byte order and 8-byte aligned. The
+// header records the SourceKey of the dictionary it was built from (size,
+// modification time and a hash of its first and last 64 KiB, see
+// source_key.h); a sidecar that does not match all three is rebuilt.
+class ValueCache {
+public:
+    enum class Kind : uint32_t {
+        kStrings = 0,
+        kInt32 = 1,
+        kInt64 = 2,
+        kFloat64 = 3,
+    };
+
+    // <cache_dir or the dictionary's directory>/<dictionary file name>.vdcache
+    static std::string sidecar_path(const std::string& dictionary_path, const std::string& cache_dir);
+
+    // Decode a dictionary and write its sidecar, through a temporary file
+    // with a unique name renamed into place. If another builder's matching
+    // sidecar is already in place, that one is kept. Throws on errors.
+    static void build(const std::string& dictionary_path, const std::string& sidecar);
+
+    // Map the sidecar if it exists and matches the dictionary. Returns false,
+    // leaving the cache closed, for a missing, stale or damaged sidecar.
+    bool open(const std::string& dictionary_path, const std::string& sidecar);
+
+    Kind kind() const { return m_kind; }
+    uint64_t size() const { return m_count; }
+
+    // kStrings: value i spans [offsets()[i], offsets()[i + 1]) of data().
+    // open() does not read the offsets, so a damaged sidecar throws
+    // std::runtime_error here instead.
+    std::string_view operator[](uint64_t i) const {
+        const uint64_t begin = m_offsets[i];
+        const uint64_t end = m_offsets[i + 1];
+        if (begin > end || end > m_data_bytes) {
+            damaged();
+        }
+        return std::string_view(m_data + begin, end - begin);
+    }
+    const uint64_t* offsets() const { return m_offsets; }
+    std::string_view data() const { return std::string_view(m_data, m_data_bytes); }
+
+    // kInt32, kInt64 and kFloat64: the numbers
+    template <typename T>
+    const T* values() const { return reinterpret_cast<const T*>(m_data); }
+
+private:
+    [[noreturn]] static void damaged();
+
+    MappedFile m_file;
+    Kind m_kind = Kind::kStrings;
+    uint64_t m_count = 0;
+    uint64_t m_data_bytes = 0;
+    const uint64_t* m_offsets = nullptr;
+    const char* m_data = nullptr;
+};
+
+#endif  // VALUE_CACHE_H_